@@ -1,4 +1,10 @@
 #include "bead.h"
+#include "bead_filter.h"
+#include "bead_search.h"
+#include "bead_color_index.h"
+#include "bead_parallel.h"
+#include "bead_catalog_file.h"
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -28,55 +34,569 @@ static const char* finish_names[BEAD_FINISH_COUNT] = {
     "Faceted"
 };
 
+// Map a slot index to its segment and the offset within that segment
+static uint32_t locate_slot(uint32_t index, uint32_t* offset) {
+    uint32_t block = index / BEAD_SEGMENT_BASE + 1;
+    uint32_t segment = 0;
+#if defined(__GNUC__)
+    segment = 31 - __builtin_clz(block);
+#else
+    while (block >>= 1) segment++;
+#endif
+    *offset = index - BEAD_SEGMENT_BASE * ((1u << segment) - 1);
+    return segment;
+}
+
+static uint32_t segment_capacity(uint32_t segment) {
+    return BEAD_SEGMENT_BASE << segment;
+}
+
+static uint32_t* slot_hash(BeadCollection* collection, uint32_t index) {
+    uint32_t offset;
+    uint32_t segment = locate_slot(index, &offset);
+    return &collection->segments[segment].id_hashes[offset];
+}
+
+// Widest columns first keeps every column naturally aligned
+void attach_bead_segment_columns(BeadSegment* segment, uint8_t* columns, uint32_t capacity) {
+    segment->columns = columns;
+    segment->id_hashes = (uint32_t*)columns;
+    segment->sizes_mm = (float*)(columns + capacity * 4);
+    segment->colors = (uint32_t*)(columns + capacity * 8);
+    segment->category_ids = (uint16_t*)(columns + capacity * 12);
+    segment->materials = columns + capacity * 14;
+    segment->shapes = columns + capacity * 15;
+    segment->finishes = columns + capacity * 16;
+    segment->premium = columns + capacity * 17;
+}
+
+// Allocate the next segment, doubling capacity without touching existing definitions
+static bool add_segment(BeadCollection* collection) {
+    if (collection->num_segments >= MAX_BEAD_SEGMENTS) return false;
+
+    uint32_t capacity = segment_capacity(collection->num_segments);
+    BeadSegment* segment = &collection->segments[collection->num_segments];
+    segment->definitions = malloc(capacity * sizeof(BeadDefinition));
+
+    // Zeroed so the scan kernels read defined values past the last bead
+    uint8_t* columns = calloc(capacity, BEAD_COLUMN_BYTES);
+    if (!segment->definitions || !columns) {
+        free(segment->definitions);
+        free(columns);
+        segment->definitions = NULL;
+        return false;
+    }
+
+    attach_bead_segment_columns(segment, columns, capacity);
+    collection->num_segments++;
+    collection->capacity += capacity;
+    return true;
+}
+
+static uint8_t pack_channel(float value) {
+    if (!(value > 0.0f)) return 0;
+    if (value >= 1.0f) return 255;
+    return (uint8_t)(value * 255.0f + 0.5f);
+}
+
+uint32_t pack_bead_color(Clay_Color color) {
+    return (uint32_t)pack_channel(color.r) |
+           ((uint32_t)pack_channel(color.g) << 8) |
+           ((uint32_t)pack_channel(color.b) << 16) |
+           ((uint32_t)pack_channel(color.a) << 24);
+}
+
+Clay_Color unpack_bead_color(uint32_t packed) {
+    return (Clay_Color){
+        .r = (packed & 0xff) / 255.0f,
+        .g = ((packed >> 8) & 0xff) / 255.0f,
+        .b = ((packed >> 16) & 0xff) / 255.0f,
+        .a = ((packed >> 24) & 0xff) / 255.0f
+    };
+}
+
+BeadDefinition* get_bead_at(BeadCollection* collection, uint32_t index) {
+    if (!collection || index >= collection->count) return NULL;
+
+    uint32_t offset;
+    uint32_t segment = locate_slot(index, &offset);
+    return &collection->segments[segment].definitions[offset];
+}
+
+// Insert a slot into the id index, assuming there is room for it
+static void id_index_insert(BeadCollection* collection, uint32_t slot) {
+    uint32_t mask = collection->id_index_capacity - 1;
+    uint32_t pos = *slot_hash(collection, slot) & mask;
+    while (collection->id_index[pos] != 0) {
+        pos = (pos + 1) & mask;
+    }
+    collection->id_index[pos] = slot + 1;
+}
+
+// Find the index slot holding the given id, or the empty slot where it would go
+static uint32_t id_index_probe(BeadCollection* collection, const char* id, uint32_t hash) {
+    uint32_t mask = collection->id_index_capacity - 1;
+    uint32_t pos = hash & mask;
+    while (collection->id_index[pos] != 0) {
+        uint32_t slot = collection->id_index[pos] - 1;
+        if (*slot_hash(collection, slot) == hash) {
+            const char* slot_id = get_bead_at(collection, slot)->id;
+            if (slot_id == id || strcmp(slot_id, id) == 0) break;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+// Double the id index, reinserting slots from their stored hashes
+static bool id_index_grow(BeadCollection* collection) {
+    uint32_t new_capacity = collection->id_index_capacity * 2;
+    uint32_t* new_index = calloc(new_capacity, sizeof(uint32_t));
+    if (!new_index) return false;
+
+    uint32_t* old_index = collection->id_index;
+    uint32_t old_capacity = collection->id_index_capacity;
+    collection->id_index = new_index;
+    collection->id_index_capacity = new_capacity;
+
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old_index[i] != 0) {
+            id_index_insert(collection, old_index[i] - 1);
+        }
+    }
+    free(old_index);
+    return true;
+}
+
+static uint32_t popcount64(uint64_t bits) {
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_popcountll(bits);
+#else
+    uint32_t count = 0;
+    for (; bits; bits &= bits - 1) count++;
+    return count;
+#endif
+}
+
+static uint32_t ctz64(uint64_t bits) {
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctzll(bits);
+#else
+    uint32_t index = 0;
+    while (!(bits & 1)) { bits >>= 1; index++; }
+    return index;
+#endif
+}
+
+static void set_bit(uint64_t* bits, uint32_t index) {
+    bits[index / 64] |= (uint64_t)1 << (index % 64);
+}
+
+// Grow one bitmap to new_words, zeroing the added words
+static bool resize_bitmap(uint64_t** bits, uint32_t old_words, uint32_t new_words) {
+    uint64_t* resized = realloc(*bits, new_words * sizeof(uint64_t));
+    if (!resized) return false;
+    memset(resized + old_words, 0, (new_words - old_words) * sizeof(uint64_t));
+    *bits = resized;
+    return true;
+}
+
+// Double the length of every attribute bitmap
+static bool grow_bitmaps(BeadCollection* collection) {
+    uint32_t old_words = collection->bitmap_words;
+    uint32_t new_words = old_words ? old_words * 2 : BEAD_SEGMENT_BASE / 64;
+
+    for (int i = 0; i < BEAD_MATERIAL_COUNT; i++) {
+        if (!resize_bitmap(&collection->material_bits[i], old_words, new_words)) return false;
+    }
+    for (int i = 0; i < BEAD_SHAPE_COUNT; i++) {
+        if (!resize_bitmap(&collection->shape_bits[i], old_words, new_words)) return false;
+    }
+    for (int i = 0; i < BEAD_FINISH_COUNT; i++) {
+        if (!resize_bitmap(&collection->finish_bits[i], old_words, new_words)) return false;
+    }
+    if (!resize_bitmap(&collection->premium_bits, old_words, new_words)) return false;
+    for (uint32_t i = 0; i < collection->num_categories; i++) {
+        if (!resize_bitmap(&collection->categories[i].bits, old_words, new_words)) return false;
+    }
+
+    collection->bitmap_words = new_words;
+    return true;
+}
+
+// Categories are interned, so they are matched by pointer
+static BeadCategoryIndex* find_category(BeadCollection* collection, const char* interned_name) {
+    for (uint32_t i = 0; i < collection->num_categories; i++) {
+        if (collection->categories[i].name == interned_name) {
+            return &collection->categories[i];
+        }
+    }
+    return NULL;
+}
+
+// Find or create the bitmap index for an interned category
+static BeadCategoryIndex* get_or_add_category(BeadCollection* collection, const char* interned_name) {
+    BeadCategoryIndex* category = find_category(collection, interned_name);
+    if (category) return category;
+
+    if (collection->num_categories >= BEAD_NO_CATEGORY) return NULL;
+    if (collection->num_categories >= collection->categories_capacity) {
+        uint32_t new_capacity = collection->categories_capacity ? collection->categories_capacity * 2 : 16;
+        BeadCategoryIndex* resized = realloc(collection->categories, new_capacity * sizeof(BeadCategoryIndex));
+        if (!resized) return NULL;
+        collection->categories = resized;
+        collection->categories_capacity = new_capacity;
+    }
+
+    uint64_t* bits = calloc(collection->bitmap_words, sizeof(uint64_t));
+    if (!bits) return NULL;
+
+    category = &collection->categories[collection->num_categories++];
+    category->name = interned_name;
+    category->bits = bits;
+    return category;
+}
+
+static bool size_entry_less(BeadSizeEntry a, BeadSizeEntry b) {
+    return a.size_mm < b.size_mm || (a.size_mm == b.size_mm && a.slot < b.slot);
+}
+
+static int compare_size_entries(const void* a, const void* b) {
+    BeadSizeEntry x = *(const BeadSizeEntry*)a;
+    BeadSizeEntry y = *(const BeadSizeEntry*)b;
+    return size_entry_less(x, y) ? -1 : (size_entry_less(y, x) ? 1 : 0);
+}
+
+// Sort the pending run and merge it into the sorted part of the size index
+static void flush_size_index(BeadCollection* collection) {
+    uint32_t sorted = collection->size_index_sorted;
+    uint32_t pending = collection->size_index_count - sorted;
+    if (pending == 0) return;
+
+    // Runs longer than BEAD_SIZE_MERGE_RUN only come from bulk inserts
+    BeadSizeEntry* index = collection->size_index;
+    BeadSizeEntry stack_run[BEAD_SIZE_MERGE_RUN];
+    BeadSizeEntry* run = pending <= BEAD_SIZE_MERGE_RUN ? stack_run : malloc(pending * sizeof(BeadSizeEntry));
+    if (!run) {
+        qsort(index, collection->size_index_count, sizeof(BeadSizeEntry), compare_size_entries);
+        collection->size_index_sorted = collection->size_index_count;
+        return;
+    }
+    memcpy(run, index + sorted, pending * sizeof(BeadSizeEntry));
+    qsort(run, pending, sizeof(BeadSizeEntry), compare_size_entries);
+
+    // Merge from the back so the sorted entries only ever move right
+    int64_t i = (int64_t)sorted - 1;
+    int64_t j = (int64_t)pending - 1;
+    int64_t k = (int64_t)collection->size_index_count - 1;
+    while (j >= 0) {
+        if (i >= 0 && size_entry_less(run[j], index[i])) {
+            index[k--] = index[i--];
+        } else {
+            index[k--] = run[j--];
+        }
+    }
+    collection->size_index_sorted = collection->size_index_count;
+    if (run != stack_run) free(run);
+}
+
+// With defer_merge set, out-of-order entries pile up until the caller flushes
+static bool add_size_entry(BeadCollection* collection, float size_mm, uint32_t slot, bool defer_merge) {
+    // NaN sizes can never fall inside a range, so they are left out of the index
+    if (isnan(size_mm)) return true;
+
+    if (collection->size_index_count >= collection->size_index_capacity) {
+        uint32_t new_capacity = collection->size_index_capacity ? collection->size_index_capacity * 2 : BEAD_SEGMENT_BASE;
+        BeadSizeEntry* resized = realloc(collection->size_index, new_capacity * sizeof(BeadSizeEntry));
+        if (!resized) return false;
+        collection->size_index = resized;
+        collection->size_index_capacity = new_capacity;
+    }
+
+    BeadSizeEntry entry = { size_mm, slot };
+    uint32_t count = collection->size_index_count++;
+    collection->size_index[count] = entry;
+
+    // In-order inserts extend the sorted run directly; others wait for a batched merge
+    if (collection->size_index_sorted == count &&
+        (count == 0 || !size_entry_less(entry, collection->size_index[count - 1]))) {
+        collection->size_index_sorted++;
+    } else if (!defer_merge && collection->size_index_count - collection->size_index_sorted >= BEAD_SIZE_MERGE_RUN) {
+        flush_size_index(collection);
+    }
+    return true;
+}
+
+// First position in the sorted size index whose size is >= size_mm (or > when strict)
+static uint32_t size_index_bound(BeadCollection* collection, float size_mm, bool strict) {
+    uint32_t low = 0;
+    uint32_t high = collection->size_index_count;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        float value = collection->size_index[mid].size_mm;
+        if (strict ? value <= size_mm : value < size_mm) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
 BeadCollection* create_bead_collection(void) {
-    BeadCollection* collection = malloc(sizeof(BeadCollection));
+    BeadCollection* collection = calloc(1, sizeof(BeadCollection));
     if (!collection) return NULL;
 
-    collection->definitions = malloc(MAX_BEAD_DEFINITIONS * sizeof(BeadDefinition));
-    if (!collection->definitions) {
-        free(collection);
+    collection->id_index = calloc(BEAD_SEGMENT_BASE * 2, sizeof(uint32_t));
+    collection->strings = string_arena_create();
+    if (!collection->id_index || !collection->strings || !add_segment(collection) || !grow_bitmaps(collection)) {
+        free_bead_collection(collection);
         return NULL;
     }
 
-    collection->count = 0;
-    collection->capacity = MAX_BEAD_DEFINITIONS;
+    collection->id_index_capacity = BEAD_SEGMENT_BASE * 2;
+    collection->catalog_generation = new_bead_catalog_generation();
     return collection;
 }
 
-bool add_bead_definition(BeadCollection* collection, BeadDefinition bead) {
-    if (!collection || collection->count >= collection->capacity) {
+uint32_t new_bead_catalog_generation(void) {
+    static uint32_t last_generation = 0;
+    return __atomic_add_fetch(&last_generation, 1, __ATOMIC_RELAXED);
+}
+
+// Generations come from one counter, so no two collection states share one
+static uint64_t next_bead_generation(void) {
+    static uint64_t last_generation = 0;
+    return __atomic_add_fetch(&last_generation, 1, __ATOMIC_RELAXED);
+}
+
+static bool insert_bead(BeadCollection* collection, BeadDefinition bead, bool defer_size_merge) {
+    if (!collection || collection->frozen || collection->count == UINT32_MAX) {
         return false;
     }
+    if (collection->count >= collection->capacity && !add_segment(collection)) {
+        return false;
+    }
+
+    // Take private copies of the text. Categories are interned so they can be
+    // compared by pointer; a repeated id reuses the copy already indexed.
+    BeadDefinition* existing = bead.id ? find_bead_by_id(collection, bead.id) : NULL;
+    BeadDefinition copy = bead;
+    copy.id = existing ? existing->id : string_arena_copy(collection->strings, bead.id);
+    copy.name = string_arena_copy(collection->strings, bead.name);
+    copy.description = string_arena_copy(collection->strings, bead.description);
+    copy.category = string_arena_intern(collection->strings, bead.category);
+    if ((bead.id && !copy.id) || (bead.name && !copy.name) ||
+        (bead.description && !copy.description) || (bead.category && !copy.category)) {
+        return false;
+    }
+    bead = copy;
+
+    // Keep the index at most half full so probe chains stay short
+    if ((collection->count + 1) * 2 > collection->id_index_capacity && !id_index_grow(collection)) {
+        return false;
+    }
+    if (collection->count >= collection->bitmap_words * 64 && !grow_bitmaps(collection)) {
+        return false;
+    }
+    BeadCategoryIndex* category = NULL;
+    if (bead.category && !(category = get_or_add_category(collection, bead.category))) {
+        return false;
+    }
+    // Last, as the entry points at the slot: a failure before it leaves at
+    // most an empty category behind
+    if (!add_size_entry(collection, bead.size_mm, collection->count, defer_size_merge)) {
+        return false;
+    }
+
+    uint32_t slot = collection->count++;
+    collection->generation = next_bead_generation();
+    uint32_t offset;
+    BeadSegment* segment = &collection->segments[locate_slot(slot, &offset)];
+    segment->definitions[offset] = bead;
+    segment->id_hashes[offset] = bead.id ? hash_string(bead.id) : 0;
+    segment->materials[offset] = bead.material < BEAD_MATERIAL_COUNT ? (uint8_t)bead.material : 0xff;
+    segment->shapes[offset] = bead.shape < BEAD_SHAPE_COUNT ? (uint8_t)bead.shape : 0xff;
+    segment->finishes[offset] = bead.finish < BEAD_FINISH_COUNT ? (uint8_t)bead.finish : 0xff;
+    segment->premium[offset] = bead.is_premium ? 1 : 0;
+    segment->category_ids[offset] = category ? (uint16_t)(category - collection->categories) : BEAD_NO_CATEGORY;
+    segment->sizes_mm[offset] = bead.size_mm;
+    segment->colors[offset] = pack_bead_color(bead.color);
+
+    if (bead.material < BEAD_MATERIAL_COUNT) set_bit(collection->material_bits[bead.material], slot);
+    if (bead.shape < BEAD_SHAPE_COUNT) set_bit(collection->shape_bits[bead.shape], slot);
+    if (bead.finish < BEAD_FINISH_COUNT) set_bit(collection->finish_bits[bead.finish], slot);
+    if (bead.is_premium) set_bit(collection->premium_bits, slot);
+    if (category) set_bit(category->bits, slot);
+
+    // The first definition with a given id wins, matching the old linear scan
+    if (bead.id) {
+        uint32_t pos = id_index_probe(collection, bead.id, segment->id_hashes[offset]);
+        if (collection->id_index[pos] == 0) {
+            collection->id_index[pos] = slot + 1;
+        }
+    }
+
+    return true;
+}
 
-    collection->definitions[collection->count++] = bead;
+bool add_bead_definition(BeadCollection* collection, BeadDefinition bead) {
+    if (!insert_bead(collection, bead, false)) return false;
+
+    // A failed update is retried by the next color query
+    if (collection->color_index) update_bead_color_index(collection);
     return true;
 }
 
+uint32_t add_bead_definitions(BeadCollection* collection, const BeadDefinition* beads, uint32_t count) {
+    uint32_t added = 0;
+    while (added < count && insert_bead(collection, beads[added], true)) added++;
+    if (collection) {
+        // Merge once the pending run is large relative to the sorted part, so a
+        // stream of small batches costs O(n log n) overall; readers flush the rest
+        uint32_t pending = collection->size_index_count - collection->size_index_sorted;
+        if (pending >= BEAD_SIZE_MERGE_RUN && pending >= collection->size_index_sorted / 4) {
+            flush_size_index(collection);
+        }
+        if (collection->color_index) update_bead_color_index(collection);
+    }
+    return added;
+}
+
+const char* intern_bead_string(BeadCollection* collection, const char* str) {
+    return collection && !collection->frozen ? string_arena_intern(collection->strings, str) : NULL;
+}
+
+static bool copy_array(void** out, const void* source, size_t size) {
+    *out = NULL;
+    if (!source || size == 0) return true;
+    *out = malloc(size);
+    if (*out) memcpy(*out, source, size);
+    return *out != NULL;
+}
+
+BeadCollection* clone_bead_collection(BeadCollection* source) {
+    if (!source || source->frozen) return NULL;
+    BeadCollection* clone = calloc(1, sizeof(BeadCollection));
+    if (!clone) return NULL;
+
+    // Segments are shared: the clone only writes slots past source->count and
+    // adds segments in its own table
+    memcpy(clone->segments, source->segments, sizeof(source->segments));
+    clone->num_segments = source->num_segments;
+    clone->count = source->count;
+    clone->capacity = source->capacity;
+    clone->mapped_file = source->mapped_file;
+    clone->mapped_size = source->mapped_size;
+    clone->generation = source->generation;
+    clone->catalog_generation = source->catalog_generation;
+
+    size_t bitmap_bytes = source->bitmap_words * sizeof(uint64_t);
+    bool ok = copy_array((void**)&clone->id_index, source->id_index, source->id_index_capacity * sizeof(uint32_t)) &&
+              copy_array((void**)&clone->premium_bits, source->premium_bits, bitmap_bytes) &&
+              copy_array((void**)&clone->size_index, source->size_index, source->size_index_capacity * sizeof(BeadSizeEntry)) &&
+              copy_array((void**)&clone->categories, source->categories, source->categories_capacity * sizeof(BeadCategoryIndex));
+    clone->id_index_capacity = source->id_index_capacity;
+    clone->bitmap_words = source->bitmap_words;
+    clone->size_index_count = source->size_index_count;
+    clone->size_index_sorted = source->size_index_sorted;
+    clone->size_index_capacity = source->size_index_capacity;
+    clone->categories_capacity = source->categories_capacity;
+
+    for (int i = 0; ok && i < BEAD_MATERIAL_COUNT; i++) ok = copy_array((void**)&clone->material_bits[i], source->material_bits[i], bitmap_bytes);
+    for (int i = 0; ok && i < BEAD_SHAPE_COUNT; i++) ok = copy_array((void**)&clone->shape_bits[i], source->shape_bits[i], bitmap_bytes);
+    for (int i = 0; ok && i < BEAD_FINISH_COUNT; i++) ok = copy_array((void**)&clone->finish_bits[i], source->finish_bits[i], bitmap_bytes);
+    // Count only the categories whose bitmaps were copied, so cleanup frees exactly those
+    for (; ok && clone->num_categories < source->num_categories; clone->num_categories++) {
+        uint32_t i = clone->num_categories;
+        ok = copy_array((void**)&clone->categories[i].bits, source->categories[i].bits, bitmap_bytes);
+    }
+    // Indexes are forked once up to date, so the clone only indexes its own rows
+    if (ok && source->search_index) {
+        ok = update_bead_search_index(source) &&
+             (clone->search_index = fork_bead_search_index(source->search_index)) != NULL;
+    }
+    if (ok && source->color_index) {
+        ok = update_bead_color_index(source) &&
+             (clone->color_index = fork_bead_color_index(source->color_index)) != NULL;
+    }
+    if (ok) ok = (clone->strings = string_arena_fork(source->strings)) != NULL;
+
+    if (!ok) {
+        // Only the indexes may have been shared, so drop the copies without
+        // touching the segments
+        unfork_bead_search_index(clone->search_index, source->search_index);
+        unfork_bead_color_index(clone->color_index, source->color_index);
+        clone->search_index = NULL;
+        clone->color_index = NULL;
+        clone->num_segments = 0;
+        clone->mapped_file = NULL;
+        free_bead_collection(clone);
+        return NULL;
+    }
+    source->frozen = true;
+    return clone;
+}
+
+void discard_bead_collection_clone(BeadCollection* clone, BeadCollection* source) {
+    if (!clone || !source) return;
+
+    // Free the segments the clone added; the rest go back to source
+    for (uint32_t i = source->num_segments; i < clone->num_segments; i++) {
+        free(clone->segments[i].definitions);
+        free(clone->segments[i].columns);
+    }
+    string_arena_unfork(clone->strings, source->strings);
+    unfork_bead_search_index(clone->search_index, source->search_index);
+    unfork_bead_color_index(clone->color_index, source->color_index);
+    clone->strings = NULL;
+    clone->search_index = NULL;
+    clone->color_index = NULL;
+    clone->num_segments = 0;
+    clone->mapped_file = NULL;
+    free_bead_collection(clone);
+    source->frozen = false;
+}
+
 BeadDefinition* find_bead_by_id(BeadCollection* collection, const char* id) {
     if (!collection || !id) return NULL;
 
-    for (uint32_t i = 0; i < collection->count; i++) {
-        if (strcmp(collection->definitions[i].id, id) == 0) {
-            return &collection->definitions[i];
+    uint32_t pos = id_index_probe(collection, id, hash_string(id));
+    uint32_t entry = collection->id_index[pos];
+    return entry ? get_bead_at(collection, entry - 1) : NULL;
+}
+
+BeadHandle get_bead_handle(BeadCollection* collection, const BeadDefinition* bead) {
+    if (!collection || !bead) return (BeadHandle){0};
+
+    // Ids may repeat, so find the slot from the address rather than the id
+    for (uint32_t k = 0; k < collection->num_segments; k++) {
+        const BeadDefinition* definitions = collection->segments[k].definitions;
+        if (bead >= definitions && bead < definitions + segment_capacity(k)) {
+            uint32_t slot = BEAD_SEGMENT_BASE * ((1u << k) - 1) + (uint32_t)(bead - definitions);
+            if (slot >= collection->count) break;
+            return (BeadHandle){ slot + 1, collection->catalog_generation };
         }
     }
-    return NULL;
+    return (BeadHandle){0};
 }
 
-// Helper function to count matching beads
-static uint32_t count_matching_beads(BeadCollection* collection, bool (*matcher)(BeadDefinition*, void*), void* criteria) {
-    uint32_t count = 0;
-    for (uint32_t i = 0; i < collection->count; i++) {
-        if (matcher(&collection->definitions[i], criteria)) {
-            count++;
-        }
+BeadDefinition* get_bead_by_handle(BeadCollection* collection, BeadHandle handle) {
+    if (!collection || handle.index == 0 || handle.generation != collection->catalog_generation) {
+        return NULL;
     }
-    return count;
+    return get_bead_at(collection, handle.index - 1);
 }
 
-// Helper function to collect matching beads
-static BeadDefinition** collect_matching_beads(BeadCollection* collection, bool (*matcher)(BeadDefinition*, void*), void* criteria, uint32_t* count) {
-    *count = count_matching_beads(collection, matcher, criteria);
+// Helper function to collect the beads whose bits are set, in slot order
+static BeadDefinition** collect_bitmap_beads(BeadCollection* collection, const uint64_t* bits, uint32_t* count) {
+    uint32_t words = get_bead_bitmap_words(collection);
+    *count = 0;
+    if (!bits) return NULL;
+
+    for (uint32_t w = 0; w < words; w++) {
+        *count += popcount64(bits[w]);
+    }
     if (*count == 0) return NULL;
 
     BeadDefinition** results = malloc(*count * sizeof(BeadDefinition*));
@@ -86,68 +606,637 @@ static BeadDefinition** collect_matching_beads(BeadCollection* collection, bool
     }
 
     uint32_t index = 0;
-    for (uint32_t i = 0; i < collection->count; i++) {
-        if (matcher(&collection->definitions[i], criteria)) {
-            results[index++] = &collection->definitions[i];
+    for (uint32_t w = 0; w < words; w++) {
+        for (uint64_t word = bits[w]; word; word &= word - 1) {
+            results[index++] = get_bead_at(collection, w * 64 + ctz64(word));
         }
     }
-
     return results;
 }
 
-// Matcher functions for different criteria
-static bool match_category(BeadDefinition* bead, void* category) {
-    return strcmp(bead->category, (const char*)category) == 0;
+// Bitmap for a single query term, or NULL when nothing can match it
+static const uint64_t* get_term_bits(BeadCollection* collection, const BeadQueryTerm* term) {
+    switch (term->field) {
+        case BEAD_FIELD_MATERIAL:
+            return (term->value >= 0 && term->value < BEAD_MATERIAL_COUNT) ? collection->material_bits[term->value] : NULL;
+        case BEAD_FIELD_SHAPE:
+            return (term->value >= 0 && term->value < BEAD_SHAPE_COUNT) ? collection->shape_bits[term->value] : NULL;
+        case BEAD_FIELD_FINISH:
+            return (term->value >= 0 && term->value < BEAD_FINISH_COUNT) ? collection->finish_bits[term->value] : NULL;
+        case BEAD_FIELD_CATEGORY: {
+            // A category that was never interned has no beads
+            const char* interned = string_arena_find(collection->strings, term->category);
+            BeadCategoryIndex* category = interned ? find_category(collection, interned) : NULL;
+            return category ? category->bits : NULL;
+        }
+        case BEAD_FIELD_PREMIUM:
+            // Non-premium terms are evaluated as the complement of this bitmap
+            return collection->premium_bits;
+    }
+    return NULL;
 }
 
-static bool match_material(BeadDefinition* bead, void* material) {
-    return bead->material == *(BeadMaterial*)material;
+uint32_t get_bead_bitmap_words(BeadCollection* collection) {
+    return collection ? (collection->count + 63) / 64 : 0;
 }
 
-static bool match_shape(BeadDefinition* bead, void* shape) {
-    return bead->shape == *(BeadShape*)shape;
-}
+uint32_t get_bead_query_bitmap(BeadCollection* collection, const BeadQueryTerm* terms, uint32_t num_terms, uint64_t* out_bits) {
+    uint32_t words = get_bead_bitmap_words(collection);
+    if (words == 0 || !out_bits) return 0;
+
+    // No terms selects everything; the first term is applied to that universe
+    memset(out_bits, 0xff, words * sizeof(uint64_t));
+
+    for (uint32_t t = 0; t < num_terms; t++) {
+        const uint64_t* bits = get_term_bits(collection, &terms[t]);
+        bool negate = terms[t].op == BEAD_QUERY_AND_NOT || terms[t].op == BEAD_QUERY_OR_NOT;
+        // OR against an empty start is the same as AND against everything
+        bool is_or = t > 0 && (terms[t].op == BEAD_QUERY_OR || terms[t].op == BEAD_QUERY_OR_NOT);
+        if (terms[t].field == BEAD_FIELD_PREMIUM && !terms[t].value) {
+            negate = !negate;
+        }
+
+        if (is_or && negate) {
+            for (uint32_t w = 0; w < words; w++) out_bits[w] |= bits ? ~bits[w] : ~(uint64_t)0;
+        } else if (is_or) {
+            if (bits) for (uint32_t w = 0; w < words; w++) out_bits[w] |= bits[w];
+        } else if (negate) {
+            if (bits) for (uint32_t w = 0; w < words; w++) out_bits[w] &= ~bits[w];
+        } else {
+            for (uint32_t w = 0; w < words; w++) out_bits[w] &= bits ? bits[w] : 0;
+        }
+    }
+
+    // Clear the bits past the last bead that NOT terms may have set
+    if (collection->count % 64) {
+        out_bits[words - 1] &= ((uint64_t)1 << (collection->count % 64)) - 1;
+    }
 
-static bool match_finish(BeadDefinition* bead, void* finish) {
-    return bead->finish == *(BeadFinish*)finish;
+    uint32_t count = 0;
+    for (uint32_t w = 0; w < words; w++) {
+        count += popcount64(out_bits[w]);
+    }
+    return count;
 }
 
-typedef struct {
-    float size;
-    float tolerance;
-} SizeCriteria;
+BeadDefinition** get_beads_by_query(BeadCollection* collection, const BeadQueryTerm* terms, uint32_t num_terms, uint32_t* count) {
+    *count = 0;
+    uint32_t words = get_bead_bitmap_words(collection);
+    if (words == 0) return NULL;
 
-static bool match_size(BeadDefinition* bead, void* criteria) {
-    SizeCriteria* size_criteria = (SizeCriteria*)criteria;
-    float diff = bead->size_mm - size_criteria->size;
-    return (diff >= -size_criteria->tolerance && diff <= size_criteria->tolerance);
+    uint64_t* bits = malloc(words * sizeof(uint64_t));
+    if (!bits) return NULL;
+
+    get_bead_query_bitmap(collection, terms, num_terms, bits);
+    BeadDefinition** results = collect_bitmap_beads(collection, bits, count);
+    free(bits);
+    return results;
 }
 
 // Implementation of getter functions
 BeadDefinition** get_beads_by_category(BeadCollection* collection, const char* category, uint32_t* count) {
-    return collect_matching_beads(collection, match_category, (void*)category, count);
+    BeadFilter filter = make_bead_filter();
+    filter.category = category;
+    if (!category) {
+        *count = 0;
+        return NULL;
+    }
+    return get_beads_by_filter(collection, &filter, count);
 }
 
 BeadDefinition** get_beads_by_material(BeadCollection* collection, BeadMaterial material, uint32_t* count) {
-    return collect_matching_beads(collection, match_material, &material, count);
+    BeadFilter filter = make_bead_filter();
+    filter.material = material;
+    return get_beads_by_filter(collection, &filter, count);
 }
 
 BeadDefinition** get_beads_by_shape(BeadCollection* collection, BeadShape shape, uint32_t* count) {
-    return collect_matching_beads(collection, match_shape, &shape, count);
+    BeadFilter filter = make_bead_filter();
+    filter.shape = shape;
+    return get_beads_by_filter(collection, &filter, count);
 }
 
 BeadDefinition** get_beads_by_finish(BeadCollection* collection, BeadFinish finish, uint32_t* count) {
-    return collect_matching_beads(collection, match_finish, &finish, count);
+    BeadFilter filter = make_bead_filter();
+    filter.finish = finish;
+    return get_beads_by_filter(collection, &filter, count);
+}
+
+BeadFilter make_bead_filter(void) {
+    return (BeadFilter){
+        .material = BEAD_FILTER_ANY,
+        .shape = BEAD_FILTER_ANY,
+        .finish = BEAD_FILTER_ANY,
+        .premium = BEAD_FILTER_ANY,
+        .category = NULL,
+        .match_size = false
+    };
+}
+
+BeadCursor open_bead_cursor(BeadCollection* collection, const BeadFilter* filter) {
+    BeadCursor cursor;
+    memset(&cursor, 0, sizeof(cursor));
+    cursor.collection = collection;
+    if (!collection || !filter) return cursor;
+    cursor.filter = *filter;
+
+    // Values outside an enum's range, unknown categories and empty size
+    // ranges can never match
+    if (filter->material >= BEAD_MATERIAL_COUNT || filter->shape >= BEAD_SHAPE_COUNT ||
+        filter->finish >= BEAD_FINISH_COUNT || filter->premium > 1 ||
+        (filter->match_size && !(filter->min_size_mm <= filter->max_size_mm))) {
+        return cursor;
+    }
+    if (filter->category) {
+        BeadQueryTerm term = { .op = BEAD_QUERY_AND, .field = BEAD_FIELD_CATEGORY, .category = filter->category };
+        cursor.category_bits = get_term_bits(collection, &term);
+        if (!cursor.category_bits) return cursor;
+    }
+
+    // A single equality test is already answered by a bitmap index; anything
+    // else runs the column scan kernels, with the category ANDed in afterwards
+    int constrained = (filter->material >= 0) + (filter->shape >= 0) + (filter->finish >= 0) +
+                      (filter->premium >= 0) + (filter->category != NULL) + filter->match_size;
+    if (constrained == 1 && filter->category) {
+        cursor.index_bits = cursor.category_bits;
+    } else if (constrained == 1 && filter->premium != 0 && !filter->match_size) {
+        if (filter->material >= 0) cursor.index_bits = collection->material_bits[filter->material];
+        if (filter->shape >= 0) cursor.index_bits = collection->shape_bits[filter->shape];
+        if (filter->finish >= 0) cursor.index_bits = collection->finish_bits[filter->finish];
+        if (filter->premium == 1) cursor.index_bits = collection->premium_bits;
+    }
+
+    cursor.end = collection->count;
+    return cursor;
+}
+
+// Evaluate the cursor's filter for the block of slots starting at block_start
+static void evaluate_cursor_block(const BeadCursor* cursor, uint32_t block_start, uint64_t* bits) {
+    uint32_t words = BEAD_CURSOR_BLOCK / 64;
+    uint32_t count = cursor->end - block_start;
+    if (count > BEAD_CURSOR_BLOCK) count = BEAD_CURSOR_BLOCK;
+
+    if (cursor->index_bits) {
+        memcpy(bits, cursor->index_bits + block_start / 64, words * sizeof(uint64_t));
+    } else {
+        // Blocks never straddle segments, so the kernel runs on a view into one
+        uint32_t offset;
+        BeadSegment view = cursor->collection->segments[locate_slot(block_start, &offset)];
+        view.materials += offset;
+        view.shapes += offset;
+        view.finishes += offset;
+        view.premium += offset;
+        view.sizes_mm += offset;
+        filter_bead_segment(&view, count, &cursor->filter, bits);
+        for (uint32_t w = (count + 63) / 64; w < words; w++) {
+            bits[w] = 0;
+        }
+        if (cursor->category_bits) {
+            for (uint32_t w = 0; w < words; w++) {
+                bits[w] &= cursor->category_bits[block_start / 64 + w];
+            }
+        }
+    }
+
+    // Drop anything past the last bead
+    for (uint32_t w = 0; w < words; w++) {
+        uint32_t first = w * 64;
+        if (first >= count) {
+            bits[w] = 0;
+        } else if (count - first < 64) {
+            bits[w] &= ((uint64_t)1 << (count - first)) - 1;
+        }
+    }
+}
+
+BeadDefinition* next_bead(BeadCursor* cursor) {
+    if (!cursor) return NULL;
+
+    for (;;) {
+        for (uint32_t w = 0; w < BEAD_CURSOR_BLOCK / 64; w++) {
+            if (cursor->bits[w]) {
+                uint32_t slot = cursor->block_start + w * 64 + ctz64(cursor->bits[w]);
+                cursor->bits[w] &= cursor->bits[w] - 1;
+                return get_bead_at(cursor->collection, slot);
+            }
+        }
+        if (cursor->next_block >= cursor->end) return NULL;
+
+        cursor->block_start = cursor->next_block;
+        cursor->next_block += BEAD_CURSOR_BLOCK;
+        evaluate_cursor_block(cursor, cursor->block_start, cursor->bits);
+    }
+}
+
+// A filter scan split into partitions of whole cursor blocks, so partitions
+// write disjoint bitmap words and can run on the worker pool
+typedef struct {
+    const BeadCursor* cursor;
+    uint32_t partition_blocks;    // Cursor blocks per partition
+    uint64_t* bits;               // Bitmap of `words` words to fill, or NULL to only count
+    uint32_t words;
+    uint32_t counts[MAX_BEAD_PARALLEL_THREADS * 4];   // Matches per partition
+    uint32_t offsets[MAX_BEAD_PARALLEL_THREADS * 4];  // First output position of each partition
+    BeadDefinition** out;
+    uint32_t capacity;
+} PartitionedScan;
+
+static void scan_partition(uint32_t partition, void* context) {
+    PartitionedScan* scan = context;
+    uint32_t first = partition * scan->partition_blocks * BEAD_CURSOR_BLOCK;
+    uint32_t last = first + scan->partition_blocks * BEAD_CURSOR_BLOCK;
+    if (last > scan->cursor->end) last = scan->cursor->end;
+
+    uint32_t count = 0;
+    for (uint32_t block = first; block < last; block += BEAD_CURSOR_BLOCK) {
+        uint64_t bits[BEAD_CURSOR_BLOCK / 64];
+        evaluate_cursor_block(scan->cursor, block, bits);
+        for (uint32_t w = 0; w < BEAD_CURSOR_BLOCK / 64; w++) {
+            if (scan->bits && block / 64 + w < scan->words) scan->bits[block / 64 + w] = bits[w];
+            count += popcount64(bits[w]);
+        }
+    }
+    scan->counts[partition] = count;
+}
+
+static void emit_partition(uint32_t partition, void* context) {
+    PartitionedScan* scan = context;
+    uint32_t index = scan->offsets[partition];
+    uint32_t first = partition * scan->partition_blocks * (BEAD_CURSOR_BLOCK / 64);
+    uint32_t last = first + scan->partition_blocks * (BEAD_CURSOR_BLOCK / 64);
+    if (last > scan->words) last = scan->words;
+
+    for (uint32_t w = first; w < last && index < scan->capacity; w++) {
+        for (uint64_t word = scan->bits[w]; word && index < scan->capacity; word &= word - 1) {
+            scan->out[index++] = get_bead_at(scan->cursor->collection, w * 64 + ctz64(word));
+        }
+    }
+}
+
+// Evaluate a cursor on the worker pool, filling bits (get_bead_bitmap_words()
+// words, or NULL) and up to capacity results in slot order. Returns the number
+// of matches, or UINT32_MAX when the caller should scan serially instead.
+static uint32_t scan_parallel(const BeadCursor* cursor, uint64_t* bits, BeadDefinition** out, uint32_t capacity) {
+    if (cursor->end == 0 || !use_bead_parallel(cursor->end)) return UINT32_MAX;
+
+    PartitionedScan scan;
+    uint32_t blocks = (cursor->end + BEAD_CURSOR_BLOCK - 1) / BEAD_CURSOR_BLOCK;
+    uint32_t partitions = get_bead_parallel_threads() * 4;
+    scan.cursor = cursor;
+    scan.partition_blocks = (blocks + partitions - 1) / partitions;
+    partitions = (blocks + scan.partition_blocks - 1) / scan.partition_blocks;
+    scan.words = get_bead_bitmap_words(cursor->collection);
+    scan.out = out;
+    scan.capacity = out ? capacity : 0;
+
+    // Collecting beads needs the match bitmap to find each partition's output offset
+    scan.bits = bits;
+    if (!bits && scan.capacity > 0 && !(scan.bits = malloc(scan.words * sizeof(uint64_t)))) return UINT32_MAX;
+    run_bead_parallel(partitions, scan_partition, &scan);
+
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < partitions; i++) {
+        scan.offsets[i] = total;
+        total += scan.counts[i];
+    }
+    if (scan.capacity > 0) {
+        run_bead_parallel(partitions, emit_partition, &scan);
+    }
+    if (scan.bits != bits) free(scan.bits);
+    return total;
+}
+
+uint32_t get_beads_by_filter_into(BeadCollection* collection, const BeadFilter* filter,
+                                  BeadDefinition** out, uint32_t capacity) {
+    BeadCursor cursor = open_bead_cursor(collection, filter);
+    uint32_t total = scan_parallel(&cursor, NULL, out, capacity);
+    if (total != UINT32_MAX) return total;
+    total = 0;
+
+    for (uint32_t block = 0; block < cursor.end; block += BEAD_CURSOR_BLOCK) {
+        uint64_t bits[BEAD_CURSOR_BLOCK / 64];
+        evaluate_cursor_block(&cursor, block, bits);
+        for (uint32_t w = 0; w < BEAD_CURSOR_BLOCK / 64; w++) {
+            if (total >= capacity || !out) {
+                total += popcount64(bits[w]);
+                continue;
+            }
+            for (uint64_t word = bits[w]; word; word &= word - 1) {
+                if (total < capacity) {
+                    out[total] = get_bead_at(collection, block + w * 64 + ctz64(word));
+                }
+                total++;
+            }
+        }
+    }
+    return total;
+}
+
+uint32_t count_beads_by_filter(BeadCollection* collection, const BeadFilter* filter) {
+    return get_beads_by_filter_into(collection, filter, NULL, 0);
+}
+
+uint32_t get_bead_filter_bitmap(BeadCollection* collection, const BeadFilter* filter, uint64_t* out_bits) {
+    uint32_t words = get_bead_bitmap_words(collection);
+    if (words == 0 || !out_bits) return 0;
+
+    BeadCursor cursor = open_bead_cursor(collection, filter);
+    memset(out_bits, 0, words * sizeof(uint64_t));
+
+    uint32_t count = scan_parallel(&cursor, out_bits, NULL, 0);
+    if (count != UINT32_MAX) return count;
+    count = 0;
+    for (uint32_t block = 0; block < cursor.end; block += BEAD_CURSOR_BLOCK) {
+        uint64_t bits[BEAD_CURSOR_BLOCK / 64];
+        evaluate_cursor_block(&cursor, block, bits);
+        for (uint32_t w = 0; w < BEAD_CURSOR_BLOCK / 64 && block / 64 + w < words; w++) {
+            out_bits[block / 64 + w] = bits[w];
+            count += popcount64(bits[w]);
+        }
+    }
+    return count;
+}
+
+BeadDefinition** get_beads_by_filter(BeadCollection* collection, const BeadFilter* filter, uint32_t* count) {
+    *count = count_beads_by_filter(collection, filter);
+    if (*count == 0) return NULL;
+
+    BeadDefinition** results = malloc(*count * sizeof(BeadDefinition*));
+    if (!results) {
+        *count = 0;
+        return NULL;
+    }
+    get_beads_by_filter_into(collection, filter, results, *count);
+    return results;
+}
+
+static uint32_t size_facet_bucket(float size_mm) {
+    if (!(size_mm >= 1.0f)) return 0;
+    return size_mm >= BEAD_SIZE_FACET_BUCKETS - 1 ? BEAD_SIZE_FACET_BUCKETS - 1 : (uint32_t)size_mm;
+}
+
+uint32_t get_bead_facet_counts(BeadCollection* collection, const BeadFilter* filter, BeadFacetCounts* out,
+                               uint32_t* category_counts, uint32_t num_category_counts) {
+    if (!out) return 0;
+    memset(out, 0, sizeof(*out));
+    if (category_counts) memset(category_counts, 0, num_category_counts * sizeof(uint32_t));
+    if (!collection) return 0;
+
+    BeadFilter any = make_bead_filter();
+    bool unfiltered = !filter || (filter->material < 0 && filter->shape < 0 && filter->finish < 0 &&
+                                  filter->premium < 0 && !filter->category && !filter->match_size);
+    BeadCursor cursor = open_bead_cursor(collection, unfiltered ? &any : filter);
+    uint32_t num_categories = category_counts ? num_category_counts : 0;
+    if (num_categories > collection->num_categories) num_categories = collection->num_categories;
+
+    // Each matching word is ANDed with every attribute bitmap; sizes have no
+    // bitmaps, so filtered scans read them from the size column
+    for (uint32_t block = 0; block < cursor.end; block += BEAD_CURSOR_BLOCK) {
+        uint64_t bits[BEAD_CURSOR_BLOCK / 64];
+        if (unfiltered) {
+            uint32_t count = cursor.end - block;
+            for (uint32_t w = 0; w < BEAD_CURSOR_BLOCK / 64; w++) {
+                uint32_t first = w * 64;
+                bits[w] = first >= count ? 0 : (count - first >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << (count - first)) - 1);
+            }
+        } else {
+            evaluate_cursor_block(&cursor, block, bits);
+        }
+
+        uint32_t offset;
+        const float* sizes = collection->segments[locate_slot(block, &offset)].sizes_mm + offset;
+        for (uint32_t w = 0; w < BEAD_CURSOR_BLOCK / 64; w++) {
+            uint64_t word = bits[w];
+            if (!word) continue;
+            uint32_t index = block / 64 + w;
+
+            out->total += popcount64(word);
+            for (int i = 0; i < BEAD_MATERIAL_COUNT; i++) out->materials[i] += popcount64(word & collection->material_bits[i][index]);
+            for (int i = 0; i < BEAD_SHAPE_COUNT; i++) out->shapes[i] += popcount64(word & collection->shape_bits[i][index]);
+            for (int i = 0; i < BEAD_FINISH_COUNT; i++) out->finishes[i] += popcount64(word & collection->finish_bits[i][index]);
+            out->premium[1] += popcount64(word & collection->premium_bits[index]);
+            for (uint32_t i = 0; i < num_categories; i++) {
+                category_counts[i] += popcount64(word & collection->categories[i].bits[index]);
+            }
+            if (!unfiltered) {
+                for (; word; word &= word - 1) {
+                    float size_mm = sizes[w * 64 + ctz64(word)];
+                    if (!isnan(size_mm)) out->sizes[size_facet_bucket(size_mm)]++;
+                }
+            }
+        }
+    }
+    out->premium[0] = out->total - out->premium[1];
+
+    // Without a filter the sorted size index answers each bucket with two lookups
+    if (unfiltered && collection->count > 0) {
+        flush_size_index(collection);
+        uint32_t start = 0;
+        for (uint32_t i = 0; i + 1 < BEAD_SIZE_FACET_BUCKETS; i++) {
+            uint32_t end = size_index_bound(collection, (float)(i + 1), false);
+            out->sizes[i] = end - start;
+            start = end;
+        }
+        out->sizes[BEAD_SIZE_FACET_BUCKETS - 1] = collection->size_index_count - start;
+    }
+    return out->total;
+}
+
+// Canonical form of a filter for cache lookups: any negative value means
+// "any", unused size bounds are zeroed and the category is the interned
+// pointer. Returns false for an unknown category, which matches nothing.
+static bool normalize_filter(BeadCollection* collection, const BeadFilter* filter, BeadFilter* out) {
+    *out = make_bead_filter();
+    if (filter->material >= 0) out->material = filter->material;
+    if (filter->shape >= 0) out->shape = filter->shape;
+    if (filter->finish >= 0) out->finish = filter->finish;
+    if (filter->premium >= 0) out->premium = filter->premium;
+    if (filter->match_size) {
+        out->match_size = true;
+        out->min_size_mm = filter->min_size_mm;
+        out->max_size_mm = filter->max_size_mm;
+    }
+    if (filter->category) {
+        out->category = string_arena_find(collection->strings, filter->category);
+        if (!out->category) return false;
+    }
+    return true;
+}
+
+static bool same_filter(const BeadFilter* a, const BeadFilter* b) {
+    return a->material == b->material && a->shape == b->shape && a->finish == b->finish &&
+           a->premium == b->premium && a->category == b->category && a->match_size == b->match_size &&
+           a->min_size_mm == b->min_size_mm && a->max_size_mm == b->max_size_mm;
+}
+
+BeadDefinition* const* get_cached_beads_by_filter(BeadQueryCache* cache, BeadCollection* collection,
+                                                  const BeadFilter* filter, uint32_t* count) {
+    *count = 0;
+    if (!cache || !collection || !filter) return NULL;
+
+    BeadFilter key;
+    if (!normalize_filter(collection, filter, &key)) {
+        cache->stats.misses++;
+        return NULL;
+    }
+
+    // Reuse the entry for this filter if there is one, otherwise the least recently used
+    BeadQueryCacheEntry* entry = NULL;
+    BeadQueryCacheEntry* victim = &cache->entries[0];
+    for (uint32_t i = 0; i < BEAD_QUERY_CACHE_SIZE; i++) {
+        BeadQueryCacheEntry* candidate = &cache->entries[i];
+        if (candidate->valid && same_filter(&candidate->filter, &key)) {
+            entry = candidate;
+            break;
+        }
+        if (victim->valid && (!candidate->valid || candidate->last_used < victim->last_used)) {
+            victim = candidate;
+        }
+    }
+    // Category pointers are only comparable within one catalog
+    if (entry && entry->catalog_generation == collection->catalog_generation &&
+        entry->generation == collection->generation) {
+        cache->stats.hits++;
+        entry->last_used = ++cache->tick;
+        *count = entry->count;
+        return entry->beads;
+    }
+
+    cache->stats.misses++;
+    if (!entry) {
+        if (victim->valid) cache->stats.evictions++;
+        entry = victim;
+    }
+    free(entry->beads);
+    entry->filter = key;
+    entry->catalog_generation = collection->catalog_generation;
+    entry->generation = collection->generation;
+    entry->last_used = ++cache->tick;
+    entry->count = count_beads_by_filter(collection, &key);
+    entry->beads = entry->count ? malloc(entry->count * sizeof(BeadDefinition*)) : NULL;
+    entry->valid = entry->beads || entry->count == 0;
+    if (!entry->valid) {
+        entry->count = 0;
+        return NULL;
+    }
+    get_beads_by_filter_into(collection, &key, entry->beads, entry->count);
+    *count = entry->count;
+    return entry->beads;
+}
+
+BeadQueryCacheStats get_bead_query_cache_stats(const BeadQueryCache* cache) {
+    BeadQueryCacheStats stats = {0};
+    return cache ? cache->stats : stats;
+}
+
+void clear_bead_query_cache(BeadQueryCache* cache) {
+    if (!cache) return;
+    for (uint32_t i = 0; i < BEAD_QUERY_CACHE_SIZE; i++) {
+        free(cache->entries[i].beads);
+        cache->entries[i].beads = NULL;
+        cache->entries[i].count = 0;
+        cache->entries[i].valid = false;
+    }
+}
+
+BeadSizeIterator get_bead_size_iterator(BeadCollection* collection, float min_mm, float max_mm) {
+    BeadSizeIterator iterator = { collection, 0, 0 };
+    if (!collection || !(min_mm <= max_mm)) return iterator;
+
+    flush_size_index(collection);
+    iterator.position = size_index_bound(collection, min_mm, false);
+    iterator.end = size_index_bound(collection, max_mm, true);
+    return iterator;
+}
+
+BeadDefinition* next_bead_in_size_range(BeadSizeIterator* iterator) {
+    if (!iterator || iterator->position >= iterator->end) return NULL;
+    return get_bead_at(iterator->collection, iterator->collection->size_index[iterator->position++].slot);
+}
+
+BeadDefinition** get_beads_in_size_range(BeadCollection* collection, float min_mm, float max_mm, uint32_t* count) {
+    BeadSizeIterator iterator = get_bead_size_iterator(collection, min_mm, max_mm);
+    *count = iterator.end - iterator.position;
+    if (*count == 0) return NULL;
+
+    BeadDefinition** results = malloc(*count * sizeof(BeadDefinition*));
+    if (!results) {
+        *count = 0;
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < *count; i++) {
+        results[i] = next_bead_in_size_range(&iterator);
+    }
+    return results;
+}
+
+static int compare_slots(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
 }
 
 BeadDefinition** get_beads_by_size(BeadCollection* collection, float size_mm, float tolerance_mm, uint32_t* count) {
-    SizeCriteria criteria = { size_mm, tolerance_mm };
-    return collect_matching_beads(collection, match_size, &criteria, count);
+    // Look up a slightly widened range, then apply the exact tolerance test so
+    // rounding in size +/- tolerance cannot change which beads match
+    float slack = fabsf(size_mm) * 1e-6f + 1e-6f;
+    BeadSizeIterator iterator = get_bead_size_iterator(collection, size_mm - tolerance_mm - slack,
+                                                       size_mm + tolerance_mm + slack);
+    *count = 0;
+    if (iterator.position >= iterator.end) return NULL;
+
+    uint32_t* slots = malloc((iterator.end - iterator.position) * sizeof(uint32_t));
+    if (!slots) return NULL;
+
+    uint32_t matched = 0;
+    for (uint32_t i = iterator.position; i < iterator.end; i++) {
+        BeadSizeEntry entry = collection->size_index[i];
+        float diff = entry.size_mm - size_mm;
+        if (diff >= -tolerance_mm && diff <= tolerance_mm) {
+            slots[matched++] = entry.slot;
+        }
+    }
+
+    // Results keep collection order, as callers of the tolerance form expect
+    qsort(slots, matched, sizeof(uint32_t), compare_slots);
+
+    BeadDefinition** results = matched ? malloc(matched * sizeof(BeadDefinition*)) : NULL;
+    if (results) {
+        for (uint32_t i = 0; i < matched; i++) {
+            results[i] = get_bead_at(collection, slots[i]);
+        }
+        *count = matched;
+    }
+    free(slots);
+    return results;
 }
 
 void free_bead_collection(BeadCollection* collection) {
     if (collection) {
-        free(collection->definitions);
+        // A frozen collection's segments and mapping belong to its clone
+        const uint8_t* mapped = collection->mapped_file;
+        for (uint32_t i = 0; !collection->frozen && i < collection->num_segments; i++) {
+            uint8_t* columns = collection->segments[i].columns;
+            free(collection->segments[i].definitions);
+            if (!mapped || columns < mapped || columns >= mapped + collection->mapped_size) {
+                free(columns);
+            }
+        }
+        free(collection->id_index);
+        for (int i = 0; i < BEAD_MATERIAL_COUNT; i++) free(collection->material_bits[i]);
+        for (int i = 0; i < BEAD_SHAPE_COUNT; i++) free(collection->shape_bits[i]);
+        for (int i = 0; i < BEAD_FINISH_COUNT; i++) free(collection->finish_bits[i]);
+        free(collection->premium_bits);
+        for (uint32_t i = 0; i < collection->num_categories; i++) free(collection->categories[i].bits);
+        free(collection->categories);
+        free(collection->size_index);
+        free_bead_search_index(collection->search_index);
+        free_bead_color_index(collection->color_index);
+        string_arena_destroy(collection->strings);
+        if (collection->mapped_file && !collection->frozen) {
+            release_bead_catalog_mapping(collection->mapped_file, collection->mapped_size);
+        }
         free(collection);
     }
 }
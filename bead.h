@@ -1,6 +1,7 @@
 #pragma once
 
 #include "clay.h"
+#include "string_arena.h"
 
 // Bead material types
 typedef enum {
@@ -48,24 +49,272 @@ typedef struct {
     bool is_premium;        // Premium/special bead flag
 } BeadDefinition;
 
+// Trigram index over the text fields, defined in bead_search.c
+typedef struct BeadSearchIndex BeadSearchIndex;
+
+// CIELAB grid over the bead colors, defined in bead_color_index.c
+typedef struct BeadColorIndex BeadColorIndex;
+
 // Bead collection management
-#define MAX_BEAD_DEFINITIONS 256
+// Definitions live in segments that double in size, so growing the collection
+// never moves an existing BeadDefinition and pointers to them stay valid.
+#define BEAD_SEGMENT_BASE 256     // Capacity of the first segment (power of two)
+#define MAX_BEAD_SEGMENTS 24      // Segment k holds BEAD_SEGMENT_BASE << k definitions
+
+// Category id stored for beads without a category
+#define BEAD_NO_CATEGORY 0xFFFF
+
+// A segment keeps full BeadDefinition records for callers, plus packed copies
+// of the attributes that filters read, so scans touch ~18 bytes per bead
+// instead of whole records.
+typedef struct {
+    BeadDefinition* definitions;  // Full records, including the text fields
+    uint32_t* id_hashes;          // Precomputed hash of each definition's id
+    uint8_t* materials;
+    uint8_t* shapes;
+    uint8_t* finishes;
+    uint8_t* premium;             // 1 for premium beads, 0 otherwise
+    uint16_t* category_ids;       // Index into BeadCollection.categories
+    float* sizes_mm;
+    uint32_t* colors;             // Packed RGBA8, see pack_bead_color
+    void* columns;                // Single allocation backing the packed columns
+} BeadSegment;
 
+// Bytes of packed columns per slot: id hash, size, color, category id, then
+// material, shape, finish and premium
+#define BEAD_COLUMN_BYTES 18
+
+// Bitmap of the beads in one category
+typedef struct {
+    const char* name;             // Interned in the collection's string arena
+    uint64_t* bits;
+} BeadCategoryIndex;
+
+// Entry of the size index, ordered by size and then slot
 typedef struct {
-    BeadDefinition* definitions;
+    float size_mm;
+    uint32_t slot;
+} BeadSizeEntry;
+
+// Unsorted size entries are merged into the sorted run once this many pile up
+#define BEAD_SIZE_MERGE_RUN 256
+
+// Value for BeadFilter fields that should match anything
+#define BEAD_FILTER_ANY -1
+
+// Multi-attribute filter evaluated by the column scan kernels in bead_filter.c.
+// Start from make_bead_filter() and set the fields to constrain.
+typedef struct {
+    int material;           // BeadMaterial, or BEAD_FILTER_ANY
+    int shape;              // BeadShape, or BEAD_FILTER_ANY
+    int finish;             // BeadFinish, or BEAD_FILTER_ANY
+    int premium;            // 0 or 1, or BEAD_FILTER_ANY
+    const char* category;   // Category name, or NULL for any
+    bool match_size;        // Also require min_size_mm <= size_mm <= max_size_mm
+    float min_size_mm;
+    float max_size_mm;
+} BeadFilter;
+
+// Number of filter results a collection keeps cached
+#define BEAD_QUERY_CACHE_SIZE 8
+
+// A cached filter result, valid while the collection's catalog_generation
+// and generation match
+typedef struct {
+    BeadFilter filter;            // Normalized; category is the interned pointer
+    uint32_t catalog_generation;
+    uint64_t generation;
+    uint64_t last_used;           // Cache tick of the last lookup, for LRU eviction
+    BeadDefinition** beads;
+    uint32_t count;
+    bool valid;
+} BeadQueryCacheEntry;
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;              // Includes lookups of stale entries
+    uint64_t evictions;
+} BeadQueryCacheStats;
+
+// LRU cache of filter results. Lookups update it, so each reader thread keeps
+// its own and collections stay read-only under concurrent queries. Start from
+// a zeroed cache and release it with clear_bead_query_cache.
+typedef struct {
+    BeadQueryCacheEntry entries[BEAD_QUERY_CACHE_SIZE];
+    uint64_t tick;
+    BeadQueryCacheStats stats;
+} BeadQueryCache;
+
+typedef struct {
+    BeadSegment segments[MAX_BEAD_SEGMENTS];
+    uint32_t num_segments;
     uint32_t count;
     uint32_t capacity;
+    uint32_t* id_index;           // Open-addressing table of slot + 1 (0 = empty)
+    uint32_t id_index_capacity;   // Always a power of two
+    StringArena* strings;         // Owns every id, name, description and category
+
+    // Bitmap indexes with one bit per slot, maintained by add_bead_definition
+    uint64_t* material_bits[BEAD_MATERIAL_COUNT];
+    uint64_t* shape_bits[BEAD_SHAPE_COUNT];
+    uint64_t* finish_bits[BEAD_FINISH_COUNT];
+    uint64_t* premium_bits;
+    BeadCategoryIndex* categories;
+    uint32_t num_categories;
+    uint32_t categories_capacity;
+    uint32_t bitmap_words;        // Allocated length of every bitmap, in 64-bit words
+
+    // Size index: entries [0, size_index_sorted) are sorted, the rest await a merge
+    BeadSizeEntry* size_index;
+    uint32_t size_index_count;
+    uint32_t size_index_sorted;
+    uint32_t size_index_capacity;
+
+    // Built by the first search or color query, or by a catalog before it
+    // publishes the collection (see bead_snapshot.h)
+    BeadSearchIndex* search_index;
+    BeadColorIndex* color_index;    // Kept current by add_bead_definition once built
+
+    // Changed by every insert to a value no other collection has had, so
+    // results cached for an older generation are recomputed. A clone starts
+    // with its source's generation, as it holds the same beads.
+    uint64_t generation;
+
+    // Catalog file a collection was opened from with load_bead_catalog. Its
+    // strings and segment columns point into this mapping.
+    void* mapped_file;
+    size_t mapped_size;
+
+    // Set once clone_bead_collection has moved the segments, strings and file
+    // mapping to a newer version. The collection stays readable but can no
+    // longer grow, and freeing it leaves the shared storage alone.
+    bool frozen;
+    uint32_t snapshot_readers;    // Readers pinning this version, see bead_snapshot.h
+
+    // Shared by every version of one catalog; a new or loaded catalog gets a
+    // new one, so handles into a replaced catalog are recognized as stale
+    uint32_t catalog_generation;
 } BeadCollection;
 
+// Compact reference to a catalog bead. Slots never move and versions of a
+// catalog share them, so a handle stays valid for as long as the catalog.
+typedef struct {
+    uint32_t index;       // Slot + 1; 0 means no bead
+    uint32_t generation;  // catalog_generation of the catalog the slot is in
+} BeadHandle;
+
+// Cursors evaluate their filter one block of slots at a time
+#define BEAD_CURSOR_BLOCK 256
+
+// Allocation-free iterator over the beads matching a filter, in collection
+// order. It is invalidated by adding beads to the collection.
+typedef struct {
+    BeadCollection* collection;
+    BeadFilter filter;
+    const uint64_t* index_bits;     // Bitmap index that answers the filter on its own
+    const uint64_t* category_bits;  // Category bitmap ANDed into scan results
+    uint32_t end;                   // Slot count when the cursor was opened, 0 if nothing can match
+    uint32_t next_block;            // First slot of the next block to evaluate
+    uint32_t block_start;           // First slot of the buffered block
+    uint64_t bits[BEAD_CURSOR_BLOCK / 64];  // Matches in the buffered block not yet returned
+} BeadCursor;
+
+// Size facet bucket i counts beads of i to i + 1 mm; the first bucket also
+// takes smaller sizes and the last one larger sizes
+#define BEAD_SIZE_FACET_BUCKETS 20
+
+// Per-value counts of the beads matching a filter, for labels such as
+// "Glass (1,204)"
+typedef struct {
+    uint32_t total;
+    uint32_t materials[BEAD_MATERIAL_COUNT];
+    uint32_t shapes[BEAD_SHAPE_COUNT];
+    uint32_t finishes[BEAD_FINISH_COUNT];
+    uint32_t premium[2];          // Not premium, premium
+    uint32_t sizes[BEAD_SIZE_FACET_BUCKETS];
+} BeadFacetCounts;
+
+// Streaming iterator over the beads in a size range, smallest first
+typedef struct {
+    BeadCollection* collection;
+    uint32_t position;
+    uint32_t end;
+} BeadSizeIterator;
+
+// Attributes a compound query can test
+typedef enum {
+    BEAD_FIELD_MATERIAL,
+    BEAD_FIELD_SHAPE,
+    BEAD_FIELD_FINISH,
+    BEAD_FIELD_CATEGORY,
+    BEAD_FIELD_PREMIUM
+} BeadField;
+
+// How a query term combines with the result of the terms before it
+typedef enum {
+    BEAD_QUERY_AND,
+    BEAD_QUERY_OR,
+    BEAD_QUERY_AND_NOT,
+    BEAD_QUERY_OR_NOT
+} BeadQueryOp;
+
+// One term of a compound query, e.g. {BEAD_QUERY_AND_NOT, BEAD_FIELD_PREMIUM, 1}
+typedef struct {
+    BeadQueryOp op;
+    BeadField field;
+    int value;              // BeadMaterial/BeadShape/BeadFinish value, or 0/1 for premium
+    const char* category;   // Only used for BEAD_FIELD_CATEGORY
+} BeadQueryTerm;
+
 // Initialize bead collection
 BeadCollection* create_bead_collection(void);
 
-// Add a bead definition to the collection
+// Add a bead definition to the collection. Its text fields are interned into
+// the collection, so the caller keeps ownership of the strings it passed in.
 bool add_bead_definition(BeadCollection* collection, BeadDefinition bead);
 
+// Add definitions in order, stopping at the first failure, and return how many
+// were added. Size index maintenance is batched across the whole call, so this
+// is the fast path for bulk loads.
+uint32_t add_bead_definitions(BeadCollection* collection, const BeadDefinition* beads, uint32_t count);
+
+// Start the next version of a collection. The clone takes over the append-only
+// storage (definitions, packed columns, strings, file mapping), which source
+// keeps reading, and gets its own copy of the id, attribute and size indexes.
+// source's search and color indexes are brought up to date and forked, so the
+// clone only indexes the beads added to it. source is frozen afterwards.
+BeadCollection* clone_bead_collection(BeadCollection* source);
+
+// Throw away a clone and hand the shared storage back to its source
+void discard_bead_collection_clone(BeadCollection* clone, BeadCollection* source);
+
+// Intern a string into the collection's arena; it lives as long as the collection
+const char* intern_bead_string(BeadCollection* collection, const char* str);
+
+// Point a segment's column arrays into a block of capacity * BEAD_COLUMN_BYTES bytes
+void attach_bead_segment_columns(BeadSegment* segment, uint8_t* columns, uint32_t capacity);
+
+// Get the bead stored at a slot index (0 .. count - 1)
+BeadDefinition* get_bead_at(BeadCollection* collection, uint32_t index);
+
+// Pack a 0..1 float color into RGBA8 (red in the low byte)
+uint32_t pack_bead_color(Clay_Color color);
+
+// Expand a packed RGBA8 color back to 0..1 floats
+Clay_Color unpack_bead_color(uint32_t packed);
+
 // Find a bead by ID
 BeadDefinition* find_bead_by_id(BeadCollection* collection, const char* id);
 
+// Handle for a bead stored in the collection, or a null handle for any other pointer
+BeadHandle get_bead_handle(BeadCollection* collection, const BeadDefinition* bead);
+
+// Resolve a handle; NULL for a null handle or one from another catalog
+BeadDefinition* get_bead_by_handle(BeadCollection* collection, BeadHandle handle);
+
+// Next catalog_generation for a newly created or loaded collection
+uint32_t new_bead_catalog_generation(void);
+
 // Get all beads in a category
 BeadDefinition** get_beads_by_category(BeadCollection* collection, const char* category, uint32_t* count);
 
@@ -81,6 +330,72 @@ BeadDefinition** get_beads_by_finish(BeadCollection* collection, BeadFinish fini
 // Get all beads of a specific size
 BeadDefinition** get_beads_by_size(BeadCollection* collection, float size_mm, float tolerance_mm, uint32_t* count);
 
+// Number of 64-bit words in a selection bitmap covering the whole collection
+uint32_t get_bead_bitmap_words(BeadCollection* collection);
+
+// Evaluate query terms left to right into a caller-provided bitmap of
+// get_bead_bitmap_words() words. Returns the number of matching beads.
+uint32_t get_bead_query_bitmap(BeadCollection* collection, const BeadQueryTerm* terms, uint32_t num_terms, uint64_t* out_bits);
+
+// Get all beads matching a compound query, in collection order
+BeadDefinition** get_beads_by_query(BeadCollection* collection, const BeadQueryTerm* terms, uint32_t num_terms, uint32_t* count);
+
+// A filter that matches every bead
+BeadFilter make_bead_filter(void);
+
+// Evaluate a filter into a caller-provided bitmap of get_bead_bitmap_words()
+// words. Returns the number of matching beads.
+uint32_t get_bead_filter_bitmap(BeadCollection* collection, const BeadFilter* filter, uint64_t* out_bits);
+
+// Get all beads matching a filter, in collection order (caller frees)
+BeadDefinition** get_beads_by_filter(BeadCollection* collection, const BeadFilter* filter, uint32_t* count);
+
+// Count the beads matching a filter (NULL for all) per material, shape,
+// finish, premium flag and size bucket in one pass over the bitmap indexes.
+// category_counts, if not NULL, receives num_category_counts counts indexed
+// like collection->categories. Returns the number of matching beads.
+uint32_t get_bead_facet_counts(BeadCollection* collection, const BeadFilter* filter, BeadFacetCounts* out,
+                               uint32_t* category_counts, uint32_t num_category_counts);
+
+// Beads matching a filter, in collection order, served from a reader's query
+// cache until the collection changes. Versions of a catalog holding the same
+// beads share entries. The array belongs to the cache: it stays valid until
+// the filter is looked up in a changed collection, BEAD_QUERY_CACHE_SIZE
+// other filters have been looked up or the cache is cleared. Returns NULL when
+// nothing matches.
+BeadDefinition* const* get_cached_beads_by_filter(BeadQueryCache* cache, BeadCollection* collection,
+                                                  const BeadFilter* filter, uint32_t* count);
+
+// Hit, miss and eviction counts of a query cache
+BeadQueryCacheStats get_bead_query_cache_stats(const BeadQueryCache* cache);
+
+// Drop every cached result; the counters are kept
+void clear_bead_query_cache(BeadQueryCache* cache);
+
+// Start iterating the beads matching a filter
+BeadCursor open_bead_cursor(BeadCollection* collection, const BeadFilter* filter);
+
+// Next matching bead, or NULL when the cursor is exhausted
+BeadDefinition* next_bead(BeadCursor* cursor);
+
+// Write up to capacity matching beads into out, in collection order, without
+// allocating. Returns the total number of matches, which may exceed capacity.
+uint32_t get_beads_by_filter_into(BeadCollection* collection, const BeadFilter* filter,
+                                  BeadDefinition** out, uint32_t capacity);
+
+// Number of beads matching a filter, without collecting them
+uint32_t count_beads_by_filter(BeadCollection* collection, const BeadFilter* filter);
+
+// Get all beads with min_mm <= size_mm <= max_mm, ordered by size
+BeadDefinition** get_beads_in_size_range(BeadCollection* collection, float min_mm, float max_mm, uint32_t* count);
+
+// Start iterating the beads with min_mm <= size_mm <= max_mm, smallest first.
+// The iterator is invalidated by adding beads to the collection.
+BeadSizeIterator get_bead_size_iterator(BeadCollection* collection, float min_mm, float max_mm);
+
+// Next bead of a size iteration, or NULL when the range is exhausted
+BeadDefinition* next_bead_in_size_range(BeadSizeIterator* iterator);
+
 // Free bead collection
 void free_bead_collection(BeadCollection* collection);
 
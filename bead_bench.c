@@ -0,0 +1,153 @@
+// Catalog query benchmark: filter and search throughput at 1..N threads
+//
+//   bead_bench [beads] [max_threads]
+//
+// Builds a synthetic catalog (1M beads by default), then for each thread
+// count runs the same filter and search queries and prints queries per
+// second and the speedup over one thread. max_threads defaults to the
+// number of cores. Filter queries over catalogs past the parallel threshold
+// run on the pool; search runs on the calling thread and is the baseline.
+#include "bead.h"
+#include "bead_parallel.h"
+#include "bead_search.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define FILTER_ROUNDS 50
+#define SEARCH_ROUNDS 20
+#define MAX_SEARCH_RESULTS 50
+
+static const char* bench_words[] = {
+    "crystal", "glass", "amber", "jade", "pearl", "onyx", "coral", "opal",
+    "faceted", "matte", "round", "oval", "seed", "spacer", "focal", "tube"
+};
+#define NUM_BENCH_WORDS (sizeof(bench_words) / sizeof(bench_words[0]))
+
+static const char* bench_categories[] = { "Glass", "Crystal", "Stone", "Wood", "Metal" };
+
+static double now_seconds(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static uint32_t next_random(uint32_t* state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static BeadCollection* make_bench_collection(uint32_t count) {
+    BeadCollection* collection = create_bead_collection();
+    if (!collection) return NULL;
+
+    uint32_t seed = 12345;
+    char id[32];
+    char name[64];
+    for (uint32_t i = 0; i < count; i++) {
+        snprintf(id, sizeof(id), "bench_%u", i);
+        snprintf(name, sizeof(name), "%s %s %u",
+                 bench_words[next_random(&seed) % NUM_BENCH_WORDS],
+                 bench_words[next_random(&seed) % NUM_BENCH_WORDS], i % 1000);
+        BeadDefinition bead = {
+            .id = id,
+            .name = name,
+            .material = next_random(&seed) % BEAD_MATERIAL_COUNT,
+            .shape = next_random(&seed) % BEAD_SHAPE_COUNT,
+            .finish = next_random(&seed) % BEAD_FINISH_COUNT,
+            .color = { (next_random(&seed) % 256) / 255.0f, (next_random(&seed) % 256) / 255.0f,
+                       (next_random(&seed) % 256) / 255.0f, 1.0f },
+            .size_mm = 2.0f + (next_random(&seed) % 180) / 10.0f,
+            .category = bench_categories[next_random(&seed) % 5],
+            .is_premium = next_random(&seed) % 4 == 0
+        };
+        if (!add_bead_definition(collection, bead)) {
+            free_bead_collection(collection);
+            return NULL;
+        }
+    }
+    return collection;
+}
+
+// Filters from broad to narrow, as the palette issues them
+static void make_bench_filters(BeadFilter filters[4]) {
+    for (int i = 0; i < 4; i++) filters[i] = make_bead_filter();
+    filters[0].material = BEAD_MATERIAL_GLASS;
+    filters[1].match_size = true;
+    filters[1].min_size_mm = 6.0f;
+    filters[1].max_size_mm = 10.0f;
+    filters[2].category = "Crystal";
+    filters[2].premium = 1;
+    filters[3].shape = BEAD_SHAPE_ROUND;
+    filters[3].finish = BEAD_FINISH_GLOSSY;
+    filters[3].match_size = true;
+    filters[3].min_size_mm = 4.0f;
+    filters[3].max_size_mm = 8.0f;
+}
+
+static const char* bench_queries[] = { "cryst", "amber focal", "jade 42", "faceted opal" };
+#define NUM_BENCH_QUERIES (sizeof(bench_queries) / sizeof(bench_queries[0]))
+
+int main(int argc, char** argv) {
+    uint32_t count = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000000;
+    uint32_t max_threads = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : get_bead_cpu_count();
+    if (max_threads == 0) max_threads = 1;
+    if (max_threads > MAX_BEAD_PARALLEL_THREADS) max_threads = MAX_BEAD_PARALLEL_THREADS;
+
+    printf("Building %u beads...\n", count);
+    BeadCollection* collection = make_bench_collection(count);
+    BeadDefinition** out = malloc((count ? count : 1) * sizeof(BeadDefinition*));
+    if (!collection || !out) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    BeadFilter filters[4];
+    make_bench_filters(filters);
+    BeadSearchResult results[MAX_SEARCH_RESULTS];
+    // Build the search index before timing
+    search_beads(collection, bench_queries[0], BEAD_SEARCH_PREFIX, results, MAX_SEARCH_RESULTS);
+
+    printf("%u cores, parallel threshold %u beads\n", get_bead_cpu_count(), get_bead_parallel_threshold());
+    printf("%7s %14s %8s %14s %8s\n", "threads", "filter q/s", "speedup", "search q/s", "speedup");
+
+    double filter_base = 0.0, search_base = 0.0;
+    uint64_t checksum = 0;
+    // Doubling thread counts up to max_threads, which is always measured
+    for (uint32_t threads = 1;; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        set_bead_parallel_threads(threads);
+        // Warm up the pool at this size
+        checksum += get_beads_by_filter_into(collection, &filters[0], out, count);
+
+        double start = now_seconds();
+        for (int round = 0; round < FILTER_ROUNDS; round++) {
+            for (int f = 0; f < 4; f++) {
+                checksum += get_beads_by_filter_into(collection, &filters[f], out, count);
+            }
+        }
+        double filter_rate = FILTER_ROUNDS * 4 / (now_seconds() - start);
+
+        start = now_seconds();
+        for (int round = 0; round < SEARCH_ROUNDS; round++) {
+            for (uint32_t q = 0; q < NUM_BENCH_QUERIES; q++) {
+                BeadSearchMode mode = q % 2 ? BEAD_SEARCH_FUZZY : BEAD_SEARCH_PREFIX;
+                checksum += search_beads(collection, bench_queries[q], mode, results, MAX_SEARCH_RESULTS);
+            }
+        }
+        double search_rate = SEARCH_ROUNDS * NUM_BENCH_QUERIES / (now_seconds() - start);
+
+        if (threads == 1) {
+            filter_base = filter_rate;
+            search_base = search_rate;
+        }
+        printf("%7u %14.1f %7.2fx %14.1f %7.2fx\n", threads, filter_rate, filter_rate / filter_base,
+               search_rate, search_rate / search_base);
+        if (threads == max_threads) break;
+    }
+    printf("checksum %llu\n", (unsigned long long)checksum);
+
+    shutdown_bead_parallel();
+    free(out);
+    free_bead_collection(collection);
+    return 0;
+}
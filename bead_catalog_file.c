@@ -0,0 +1,530 @@
+// Binary catalog writer and zero-copy loader for BeadCollection
+#include "bead_catalog_file.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BEAD_CATALOG_MAGIC "BEADCAT"
+#define BEAD_CATALOG_BYTE_ORDER 0x01020304u
+#define BEAD_CATALOG_ALIGN 64
+#define BEAD_CATALOG_NO_STRING UINT32_MAX
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;          // BEAD_CATALOG_BYTE_ORDER as the writer stored it
+    uint32_t header_size;
+    uint32_t count;
+    uint32_t num_segments;
+    uint32_t num_categories;
+    uint32_t bitmap_words;
+    uint32_t id_index_capacity;
+    uint32_t size_index_count;
+    uint32_t reserved;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t records_offset;
+    uint64_t columns_offset;
+    uint64_t categories_offset;
+    uint64_t bitmaps_offset;
+    uint64_t id_index_offset;
+    uint64_t size_index_offset;
+    uint64_t file_size;
+} BeadCatalogHeader;
+
+// Text and exact color of one bead; everything else comes from the columns
+typedef struct {
+    uint32_t id;
+    uint32_t name;
+    uint32_t description;
+    uint32_t image_id;
+    float color[4];
+} BeadCatalogRecord;
+
+static uint64_t align_offset(uint64_t offset) {
+    return (offset + BEAD_CATALOG_ALIGN - 1) & ~(uint64_t)(BEAD_CATALOG_ALIGN - 1);
+}
+
+static uint32_t num_bitmaps(uint32_t num_categories) {
+    return BEAD_MATERIAL_COUNT + BEAD_SHAPE_COUNT + BEAD_FINISH_COUNT + 1 + num_categories;
+}
+
+static uint64_t columns_size(uint32_t num_segments) {
+    uint64_t size = 0;
+    for (uint32_t i = 0; i < num_segments; i++) {
+        size += (uint64_t)(BEAD_SEGMENT_BASE << i) * BEAD_COLUMN_BYTES;
+    }
+    return size;
+}
+
+// Writer-side string table: a growing blob plus a hash set of offsets, so
+// repeated names, descriptions and categories are stored once
+typedef struct {
+    char* data;
+    size_t size;
+    size_t capacity;
+    uint32_t* slots;              // Offset + 1 of each stored string (0 = empty)
+    uint32_t slot_capacity;       // Always a power of two
+    uint32_t count;
+    bool failed;
+} CatalogStrings;
+
+static bool grow_string_slots(CatalogStrings* strings) {
+    uint32_t new_capacity = strings->slot_capacity ? strings->slot_capacity * 2 : 1024;
+    uint32_t* slots = calloc(new_capacity, sizeof(uint32_t));
+    if (!slots) return false;
+
+    for (uint32_t i = 0; i < strings->slot_capacity; i++) {
+        uint32_t entry = strings->slots[i];
+        if (entry == 0) continue;
+        uint32_t pos = hash_string(strings->data + entry - 1) & (new_capacity - 1);
+        while (slots[pos] != 0) pos = (pos + 1) & (new_capacity - 1);
+        slots[pos] = entry;
+    }
+    free(strings->slots);
+    strings->slots = slots;
+    strings->slot_capacity = new_capacity;
+    return true;
+}
+
+static uint32_t add_catalog_string(CatalogStrings* strings, const char* str) {
+    if (!str || strings->failed) return BEAD_CATALOG_NO_STRING;
+
+    if ((strings->count + 1) * 2 > strings->slot_capacity && !grow_string_slots(strings)) {
+        strings->failed = true;
+        return BEAD_CATALOG_NO_STRING;
+    }
+    uint32_t mask = strings->slot_capacity - 1;
+    uint32_t pos = hash_string(str) & mask;
+    while (strings->slots[pos] != 0) {
+        uint32_t offset = strings->slots[pos] - 1;
+        if (strcmp(strings->data + offset, str) == 0) return offset;
+        pos = (pos + 1) & mask;
+    }
+
+    size_t length = strlen(str) + 1;
+    if (strings->size + length >= BEAD_CATALOG_NO_STRING) {
+        strings->failed = true;
+        return BEAD_CATALOG_NO_STRING;
+    }
+    if (strings->size + length > strings->capacity) {
+        size_t new_capacity = strings->capacity ? strings->capacity * 2 : 64 * 1024;
+        while (new_capacity < strings->size + length) new_capacity *= 2;
+        char* data = realloc(strings->data, new_capacity);
+        if (!data) {
+            strings->failed = true;
+            return BEAD_CATALOG_NO_STRING;
+        }
+        strings->data = data;
+        strings->capacity = new_capacity;
+    }
+
+    uint32_t offset = (uint32_t)strings->size;
+    memcpy(strings->data + offset, str, length);
+    strings->size += length;
+    strings->slots[pos] = offset + 1;
+    strings->count++;
+    return offset;
+}
+
+static int compare_size_entries(const void* a, const void* b) {
+    const BeadSizeEntry* x = a;
+    const BeadSizeEntry* y = b;
+    if (x->size_mm != y->size_mm) return x->size_mm < y->size_mm ? -1 : 1;
+    return (x->slot > y->slot) - (x->slot < y->slot);
+}
+
+// Write a section at offset, zero-padding from the current position
+static bool write_section(FILE* file, uint64_t* position, uint64_t offset, const void* data, uint64_t size) {
+    static const uint8_t zeros[BEAD_CATALOG_ALIGN] = {0};
+    while (*position < offset) {
+        uint64_t pad = offset - *position < BEAD_CATALOG_ALIGN ? offset - *position : BEAD_CATALOG_ALIGN;
+        if (fwrite(zeros, 1, (size_t)pad, file) != pad) return false;
+        *position += pad;
+    }
+    if (size > 0 && fwrite(data, 1, (size_t)size, file) != size) return false;
+    *position += size;
+    return true;
+}
+
+static bool write_catalog(FILE* file, BeadCollection* collection, const BeadCatalogHeader* header,
+                          const CatalogStrings* strings, const BeadCatalogRecord* records,
+                          const uint32_t* category_names, const BeadSizeEntry* sizes) {
+    uint64_t position = 0;
+    uint64_t bitmap_bytes = (uint64_t)collection->bitmap_words * sizeof(uint64_t);
+
+    if (!write_section(file, &position, 0, header, sizeof(*header))) return false;
+    if (!write_section(file, &position, header->strings_offset, strings->data, strings->size)) return false;
+    if (!write_section(file, &position, header->records_offset, records,
+                       (uint64_t)collection->count * sizeof(BeadCatalogRecord))) return false;
+
+    uint64_t offset = header->columns_offset;
+    for (uint32_t i = 0; i < collection->num_segments; i++) {
+        uint64_t size = (uint64_t)(BEAD_SEGMENT_BASE << i) * BEAD_COLUMN_BYTES;
+        if (!write_section(file, &position, offset, collection->segments[i].columns, size)) return false;
+        offset += size;
+    }
+
+    if (!write_section(file, &position, header->categories_offset, category_names,
+                       (uint64_t)collection->num_categories * sizeof(uint32_t))) return false;
+
+    offset = header->bitmaps_offset;
+    for (int i = 0; i < BEAD_MATERIAL_COUNT; i++, offset += bitmap_bytes) {
+        if (!write_section(file, &position, offset, collection->material_bits[i], bitmap_bytes)) return false;
+    }
+    for (int i = 0; i < BEAD_SHAPE_COUNT; i++, offset += bitmap_bytes) {
+        if (!write_section(file, &position, offset, collection->shape_bits[i], bitmap_bytes)) return false;
+    }
+    for (int i = 0; i < BEAD_FINISH_COUNT; i++, offset += bitmap_bytes) {
+        if (!write_section(file, &position, offset, collection->finish_bits[i], bitmap_bytes)) return false;
+    }
+    if (!write_section(file, &position, offset, collection->premium_bits, bitmap_bytes)) return false;
+    offset += bitmap_bytes;
+    for (uint32_t i = 0; i < collection->num_categories; i++, offset += bitmap_bytes) {
+        if (!write_section(file, &position, offset, collection->categories[i].bits, bitmap_bytes)) return false;
+    }
+
+    if (!write_section(file, &position, header->id_index_offset, collection->id_index,
+                       (uint64_t)collection->id_index_capacity * sizeof(uint32_t))) return false;
+    if (!write_section(file, &position, header->size_index_offset, sizes,
+                       (uint64_t)collection->size_index_count * sizeof(BeadSizeEntry))) return false;
+    return position == header->file_size;
+}
+
+bool save_bead_catalog(BeadCollection* collection, const char* path) {
+    if (!collection || !path) return false;
+
+    uint32_t count = collection->count;
+    CatalogStrings strings = {0};
+    BeadCatalogRecord* records = malloc((count ? count : 1) * sizeof(BeadCatalogRecord));
+    uint32_t* category_names = malloc((collection->num_categories ? collection->num_categories : 1) * sizeof(uint32_t));
+    BeadSizeEntry* sizes = malloc((collection->size_index_count ? collection->size_index_count : 1) * sizeof(BeadSizeEntry));
+    bool ok = records && category_names && sizes;
+
+    for (uint32_t i = 0; ok && i < count; i++) {
+        BeadDefinition* bead = get_bead_at(collection, i);
+        records[i].id = add_catalog_string(&strings, bead->id);
+        records[i].name = add_catalog_string(&strings, bead->name);
+        records[i].description = add_catalog_string(&strings, bead->description);
+        records[i].image_id = bead->image_id;
+        records[i].color[0] = bead->color.r;
+        records[i].color[1] = bead->color.g;
+        records[i].color[2] = bead->color.b;
+        records[i].color[3] = bead->color.a;
+    }
+    for (uint32_t i = 0; ok && i < collection->num_categories; i++) {
+        category_names[i] = add_catalog_string(&strings, collection->categories[i].name);
+    }
+    // An empty table still needs one byte so every offset is NUL-terminated
+    if (ok && strings.size == 0) add_catalog_string(&strings, "");
+    ok = ok && !strings.failed;
+
+    // The in-memory size index may have an unmerged tail; the file's is fully sorted
+    if (ok && collection->size_index_count > 0) {
+        memcpy(sizes, collection->size_index, collection->size_index_count * sizeof(BeadSizeEntry));
+        qsort(sizes, collection->size_index_count, sizeof(BeadSizeEntry), compare_size_entries);
+    }
+
+    BeadCatalogHeader header = {0};
+    memcpy(header.magic, BEAD_CATALOG_MAGIC, sizeof(BEAD_CATALOG_MAGIC));
+    header.version = BEAD_CATALOG_VERSION;
+    header.byte_order = BEAD_CATALOG_BYTE_ORDER;
+    header.header_size = sizeof(BeadCatalogHeader);
+    header.count = count;
+    header.num_segments = collection->num_segments;
+    header.num_categories = collection->num_categories;
+    header.bitmap_words = collection->bitmap_words;
+    header.id_index_capacity = collection->id_index_capacity;
+    header.size_index_count = collection->size_index_count;
+    header.strings_offset = align_offset(sizeof(BeadCatalogHeader));
+    header.strings_size = strings.size;
+    header.records_offset = align_offset(header.strings_offset + header.strings_size);
+    header.columns_offset = align_offset(header.records_offset + (uint64_t)count * sizeof(BeadCatalogRecord));
+    header.categories_offset = align_offset(header.columns_offset + columns_size(collection->num_segments));
+    header.bitmaps_offset = align_offset(header.categories_offset + (uint64_t)collection->num_categories * sizeof(uint32_t));
+    header.id_index_offset = align_offset(header.bitmaps_offset +
+        (uint64_t)num_bitmaps(collection->num_categories) * collection->bitmap_words * sizeof(uint64_t));
+    header.size_index_offset = align_offset(header.id_index_offset + (uint64_t)collection->id_index_capacity * sizeof(uint32_t));
+    header.file_size = header.size_index_offset + (uint64_t)collection->size_index_count * sizeof(BeadSizeEntry);
+
+    // Write beside the target and rename over it, so a process that has the
+    // old file mapped never sees it change underneath
+    char temp_path[1024];
+    if (ok && snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path)) ok = false;
+    if (ok) {
+        FILE* file = fopen(temp_path, "wb");
+        ok = file != NULL;
+        if (ok) {
+            ok = write_catalog(file, collection, &header, &strings, records, category_names, sizes);
+            ok = (fclose(file) == 0) && ok;
+        }
+#ifdef _WIN32
+        if (ok) remove(path);
+#endif
+        if (ok) ok = rename(temp_path, path) == 0;
+        if (!ok) remove(temp_path);
+    }
+
+    free(strings.data);
+    free(strings.slots);
+    free(records);
+    free(category_names);
+    free(sizes);
+    return ok;
+}
+
+#ifdef _WIN32
+
+// No mmap here: read the file into memory instead
+static void* map_catalog_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    void* data = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0) length = ftell(file);
+    if (length > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)length);
+        if (data && fread(data, 1, (size_t)length, file) != (size_t)length) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    *size = data ? (size_t)length : 0;
+    return data;
+}
+
+void release_bead_catalog_mapping(void* data, size_t size) {
+    (void)size;
+    free(data);
+}
+
+#else
+
+// Map the file privately and writable, so appends after loading copy the
+// pages they touch instead of failing or writing through to the file
+static void* map_catalog_file(const char* path, size_t* size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    void* data = NULL;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            data = NULL;
+        } else {
+            *size = (size_t)info.st_size;
+        }
+    }
+    close(fd);
+    return data;
+}
+
+void release_bead_catalog_mapping(void* data, size_t size) {
+    munmap(data, size);
+}
+
+#endif
+
+static bool section_fits(const BeadCatalogHeader* header, uint64_t offset, uint64_t size) {
+    return offset % 8 == 0 && offset <= header->file_size && size <= header->file_size - offset;
+}
+
+// Same order as the size index in bead.c: by size, ties by slot
+static bool size_entry_less(BeadSizeEntry a, BeadSizeEntry b) {
+    return a.size_mm < b.size_mm || (a.size_mm == b.size_mm && a.slot < b.slot);
+}
+
+static bool validate_header(const BeadCatalogHeader* header, size_t file_size) {
+    if (file_size < sizeof(BeadCatalogHeader)) return false;
+    if (memcmp(header->magic, BEAD_CATALOG_MAGIC, sizeof(BEAD_CATALOG_MAGIC)) != 0 ||
+        header->version != BEAD_CATALOG_VERSION || header->byte_order != BEAD_CATALOG_BYTE_ORDER ||
+        header->header_size != sizeof(BeadCatalogHeader) || header->file_size != file_size) {
+        return false;
+    }
+
+    uint32_t capacity = header->id_index_capacity;
+    if (header->num_segments == 0 || header->num_segments > MAX_BEAD_SEGMENTS ||
+        header->count > columns_size(header->num_segments) / BEAD_COLUMN_BYTES ||
+        header->num_categories > BEAD_NO_CATEGORY || header->bitmap_words == 0 ||
+        header->bitmap_words % (BEAD_CURSOR_BLOCK / 64) != 0 || (uint64_t)header->bitmap_words * 64 < header->count ||
+        capacity == 0 || (capacity & (capacity - 1)) != 0 || (uint64_t)capacity < (uint64_t)header->count * 2 ||
+        header->size_index_count > header->count || header->strings_size == 0) {
+        return false;
+    }
+
+    uint64_t bitmap_bytes = (uint64_t)header->bitmap_words * sizeof(uint64_t);
+    return section_fits(header, header->strings_offset, header->strings_size) &&
+           section_fits(header, header->records_offset, (uint64_t)header->count * sizeof(BeadCatalogRecord)) &&
+           section_fits(header, header->columns_offset, columns_size(header->num_segments)) &&
+           section_fits(header, header->categories_offset, (uint64_t)header->num_categories * sizeof(uint32_t)) &&
+           section_fits(header, header->bitmaps_offset, num_bitmaps(header->num_categories) * bitmap_bytes) &&
+           section_fits(header, header->id_index_offset, (uint64_t)capacity * sizeof(uint32_t)) &&
+           section_fits(header, header->size_index_offset, (uint64_t)header->size_index_count * sizeof(BeadSizeEntry));
+}
+
+// Resolve a string offset into the mapped table; false if it is out of range
+static bool catalog_string(const char* strings, uint64_t strings_size, uint32_t offset, const char** out) {
+    if (offset == BEAD_CATALOG_NO_STRING) {
+        *out = NULL;
+        return true;
+    }
+    if (offset >= strings_size) return false;
+    *out = strings + offset;
+    return true;
+}
+
+static uint64_t* copy_bitmap(const uint8_t* data, uint64_t offset, uint32_t words) {
+    uint64_t* bits = malloc(words * sizeof(uint64_t));
+    if (bits) memcpy(bits, data + offset, words * sizeof(uint64_t));
+    return bits;
+}
+
+static bool load_sections(BeadCollection* collection, const uint8_t* data, const BeadCatalogHeader* header) {
+    const char* strings = (const char*)data + header->strings_offset;
+    if (strings[header->strings_size - 1] != '\0') return false;
+
+    // Categories are interned like any other collection's, so they compare by pointer
+    uint32_t num_categories = header->num_categories;
+    collection->categories = calloc(num_categories ? num_categories : 1, sizeof(BeadCategoryIndex));
+    if (!collection->categories) return false;
+    collection->categories_capacity = num_categories ? num_categories : 1;
+
+    uint32_t words = header->bitmap_words;
+    uint64_t bitmap_offset = header->bitmaps_offset;
+    uint64_t bitmap_bytes = (uint64_t)words * sizeof(uint64_t);
+    collection->bitmap_words = words;
+    for (int i = 0; i < BEAD_MATERIAL_COUNT; i++, bitmap_offset += bitmap_bytes) {
+        if (!(collection->material_bits[i] = copy_bitmap(data, bitmap_offset, words))) return false;
+    }
+    for (int i = 0; i < BEAD_SHAPE_COUNT; i++, bitmap_offset += bitmap_bytes) {
+        if (!(collection->shape_bits[i] = copy_bitmap(data, bitmap_offset, words))) return false;
+    }
+    for (int i = 0; i < BEAD_FINISH_COUNT; i++, bitmap_offset += bitmap_bytes) {
+        if (!(collection->finish_bits[i] = copy_bitmap(data, bitmap_offset, words))) return false;
+    }
+    if (!(collection->premium_bits = copy_bitmap(data, bitmap_offset, words))) return false;
+    bitmap_offset += bitmap_bytes;
+
+    const uint32_t* category_names = (const uint32_t*)(data + header->categories_offset);
+    for (uint32_t i = 0; i < num_categories; i++, bitmap_offset += bitmap_bytes) {
+        const char* name;
+        if (!catalog_string(strings, header->strings_size, category_names[i], &name) || !name) return false;
+        BeadCategoryIndex* category = &collection->categories[collection->num_categories];
+        category->name = string_arena_intern(collection->strings, name);
+        category->bits = copy_bitmap(data, bitmap_offset, words);
+        if (!category->name || !category->bits) {
+            free(category->bits);
+            return false;
+        }
+        collection->num_categories++;
+    }
+
+    // Segments: columns stay in the mapping, definitions are rebuilt from the records
+    const BeadCatalogRecord* records = (const BeadCatalogRecord*)(data + header->records_offset);
+    uint8_t* columns = (uint8_t*)data + header->columns_offset;
+    for (uint32_t k = 0; k < header->num_segments; k++) {
+        uint32_t capacity = BEAD_SEGMENT_BASE << k;
+        BeadSegment* segment = &collection->segments[k];
+        segment->definitions = malloc(capacity * sizeof(BeadDefinition));
+        if (!segment->definitions) return false;
+        attach_bead_segment_columns(segment, columns, capacity);
+        collection->num_segments++;
+        collection->capacity += capacity;
+        columns += (size_t)capacity * BEAD_COLUMN_BYTES;
+
+        uint32_t first = BEAD_SEGMENT_BASE * ((1u << k) - 1);
+        for (uint32_t offset = 0; offset < capacity && first + offset < header->count; offset++) {
+            const BeadCatalogRecord* record = &records[first + offset];
+            BeadDefinition* bead = &segment->definitions[offset];
+            uint16_t category_id = segment->category_ids[offset];
+            if (!catalog_string(strings, header->strings_size, record->id, &bead->id) ||
+                !catalog_string(strings, header->strings_size, record->name, &bead->name) ||
+                !catalog_string(strings, header->strings_size, record->description, &bead->description) ||
+                (category_id != BEAD_NO_CATEGORY && category_id >= num_categories)) {
+                return false;
+            }
+            bead->material = (BeadMaterial)segment->materials[offset];
+            bead->shape = (BeadShape)segment->shapes[offset];
+            bead->finish = (BeadFinish)segment->finishes[offset];
+            bead->color = (Clay_Color){ record->color[0], record->color[1], record->color[2], record->color[3] };
+            bead->image_id = record->image_id;
+            bead->size_mm = segment->sizes_mm[offset];
+            bead->category = category_id != BEAD_NO_CATEGORY ? collection->categories[category_id].name : NULL;
+            bead->is_premium = segment->premium[offset] != 0;
+        }
+    }
+    collection->count = header->count;
+
+    // The indexes are small next to the columns; copying them keeps the
+    // collection's usual grow-and-free paths valid
+    uint32_t capacity = header->id_index_capacity;
+    collection->id_index = malloc(capacity * sizeof(uint32_t));
+    if (!collection->id_index) return false;
+    memcpy(collection->id_index, data + header->id_index_offset, capacity * sizeof(uint32_t));
+    collection->id_index_capacity = capacity;
+    // Each bead is indexed at most once, which with capacity at least twice
+    // the count leaves the empty entry that ends every probe
+    uint32_t used = 0;
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (collection->id_index[i] > header->count) return false;
+        if (collection->id_index[i] != 0) used++;
+    }
+    if (used > header->count || used >= capacity) return false;
+
+    uint32_t size_count = header->size_index_count;
+    collection->size_index = malloc((size_count ? size_count : 1) * sizeof(BeadSizeEntry));
+    if (!collection->size_index) return false;
+    memcpy(collection->size_index, data + header->size_index_offset, size_count * sizeof(BeadSizeEntry));
+    // Range lookups binary search the index, so it must be strictly sorted
+    // and NaN free (a NaN size compares false both ways)
+    const BeadSizeEntry* entries = collection->size_index;
+    for (uint32_t i = 0; i < size_count; i++) {
+        if (entries[i].slot >= header->count || isnan(entries[i].size_mm)) return false;
+        if (i > 0 && !size_entry_less(entries[i - 1], entries[i])) return false;
+    }
+    collection->size_index_count = size_count;
+    collection->size_index_sorted = size_count;
+    collection->size_index_capacity = size_count ? size_count : 1;
+    return true;
+}
+
+BeadCollection* load_bead_catalog(const char* path) {
+    if (!path) return NULL;
+
+    size_t size = 0;
+    uint8_t* data = map_catalog_file(path, &size);
+    if (!data) return NULL;
+
+    const BeadCatalogHeader* header = (const BeadCatalogHeader*)data;
+    if (!validate_header(header, size)) {
+        release_bead_catalog_mapping(data, size);
+        return NULL;
+    }
+
+    BeadCollection* collection = calloc(1, sizeof(BeadCollection));
+    if (!collection) {
+        release_bead_catalog_mapping(data, size);
+        return NULL;
+    }
+    // From here on free_bead_collection releases the mapping too
+    collection->mapped_file = data;
+    collection->mapped_size = size;
+    collection->catalog_generation = new_bead_catalog_generation();
+    collection->strings = string_arena_create();
+    if (!collection->strings || !load_sections(collection, data, header)) {
+        free_bead_collection(collection);
+        return NULL;
+    }
+    return collection;
+}
@@ -0,0 +1,34 @@
+#ifndef BEAD_CATALOG_FILE_H
+#define BEAD_CATALOG_FILE_H
+
+#include "bead.h"
+
+// Binary bead catalog, version 1. All values are in the writer's byte order
+// and every section starts on a 64-byte boundary:
+//
+//   header        magic "BEADCAT", version, counts and section offsets
+//   strings       NUL-terminated strings, each distinct string stored once
+//   records       per bead: id, name and description string offsets, image id, color
+//   columns       every segment's packed columns, laid out as in memory
+//   categories    string offset of each category name
+//   bitmaps       material, shape, finish, premium, then category bitmaps
+//   id index      the collection's open-addressing id table
+//   size index    (size_mm, slot) entries sorted by size
+//
+// Loading maps the file and points the segment columns and text fields
+// straight into the mapping, so opening a catalog costs page faults rather
+// than parsing. Appending to a loaded collection works as usual; touched
+// pages become private copies and the file itself is never modified.
+#define BEAD_CATALOG_VERSION 1
+
+// Write a collection to path, replacing any existing file atomically
+bool save_bead_catalog(BeadCollection* collection, const char* path);
+
+// Open a catalog file. Returns NULL if the file is missing, truncated or was
+// written by an incompatible version; free with free_bead_collection.
+BeadCollection* load_bead_catalog(const char* path);
+
+// Release the file mapping behind a loaded collection (called by free_bead_collection)
+void release_bead_catalog_mapping(void* data, size_t size);
+
+#endif // BEAD_CATALOG_FILE_H
@@ -0,0 +1,356 @@
+// Uniform grid over CIELAB for nearest-color queries
+#include "bead_color_index.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Cells are COLOR_CELL_SIZE delta E wide. L* spans 0..100; a* and b* of
+// sRGB colors stay well inside -128..128. Colors outside are clamped into
+// the edge cells, which keeps the shell distance bounds valid.
+#define COLOR_CELL_SIZE 8.0f
+#define COLOR_CELLS_L 13
+#define COLOR_CELLS_AB 32
+#define COLOR_AB_OFFSET 128.0f
+#define COLOR_CELL_COUNT (COLOR_CELLS_L * COLOR_CELLS_AB * COLOR_CELLS_AB)
+
+typedef struct {
+    float lab[3];
+    uint32_t slot;
+} ColorEntry;
+
+typedef struct {
+    ColorEntry* entries;
+    uint32_t count;
+    uint32_t capacity;
+    bool inherited;               // entries is shared with the grid this one was forked from
+} ColorCell;
+
+struct BeadColorIndex {
+    ColorCell cells[COLOR_CELL_COUNT];
+    uint32_t indexed_count;       // Slots [0, indexed_count) are in the grid
+
+    // Inherited cell buffers a fork outgrew. Older grids still read them, so
+    // they are freed with the newest grid.
+    ColorEntry** retired;
+    uint32_t num_retired;
+    uint32_t retired_capacity;
+    bool forked;                  // The cell buffers moved to a fork; free leaves them
+};
+
+static float srgb_to_linear(float channel) {
+    if (!(channel > 0.0f)) return 0.0f;
+    if (channel >= 1.0f) return 1.0f;
+    return channel <= 0.04045f ? channel / 12.92f : powf((channel + 0.055f) / 1.055f, 2.4f);
+}
+
+static float lab_f(float t) {
+    return t > 0.008856f ? cbrtf(t) : 7.787f * t + 16.0f / 116.0f;
+}
+
+// sRGB (D65) to CIELAB
+static void color_to_lab(Clay_Color color, float lab[3]) {
+    float r = srgb_to_linear(color.r);
+    float g = srgb_to_linear(color.g);
+    float b = srgb_to_linear(color.b);
+    float x = (0.4124f * r + 0.3576f * g + 0.1805f * b) / 0.95047f;
+    float y = 0.2126f * r + 0.7152f * g + 0.0722f * b;
+    float z = (0.0193f * r + 0.1192f * g + 0.9505f * b) / 1.08883f;
+    float fx = lab_f(x);
+    float fy = lab_f(y);
+    float fz = lab_f(z);
+    lab[0] = 116.0f * fy - 16.0f;
+    lab[1] = 500.0f * (fx - fy);
+    lab[2] = 200.0f * (fy - fz);
+}
+
+static int clamp_cell(float value, int cells) {
+    int cell = (int)floorf(value / COLOR_CELL_SIZE);
+    return cell < 0 ? 0 : (cell >= cells ? cells - 1 : cell);
+}
+
+static void lab_to_cell(const float lab[3], int cell[3]) {
+    cell[0] = clamp_cell(lab[0], COLOR_CELLS_L);
+    cell[1] = clamp_cell(lab[1] + COLOR_AB_OFFSET, COLOR_CELLS_AB);
+    cell[2] = clamp_cell(lab[2] + COLOR_AB_OFFSET, COLOR_CELLS_AB);
+}
+
+static ColorCell* get_cell(BeadColorIndex* index, int l, int a, int b) {
+    return &index->cells[(l * COLOR_CELLS_AB + a) * COLOR_CELLS_AB + b];
+}
+
+static float distance_squared(const float x[3], const float y[3]) {
+    float dl = x[0] - y[0];
+    float da = x[1] - y[1];
+    float db = x[2] - y[2];
+    return dl * dl + da * da + db * db;
+}
+
+float get_color_delta_e(Clay_Color a, Clay_Color b) {
+    float lab_a[3], lab_b[3];
+    color_to_lab(a, lab_a);
+    color_to_lab(b, lab_b);
+    return sqrtf(distance_squared(lab_a, lab_b));
+}
+
+// Double a cell's capacity. An inherited cell is copied rather than
+// reallocated, since older grids read it up to their own count, and the old
+// buffer is retired.
+static bool grow_cell(BeadColorIndex* index, ColorCell* cell) {
+    uint32_t new_capacity = cell->capacity ? cell->capacity * 2 : 8;
+    if (!cell->inherited || !cell->entries) {
+        ColorEntry* resized = realloc(cell->entries, new_capacity * sizeof(ColorEntry));
+        if (!resized) return false;
+        cell->entries = resized;
+        cell->capacity = new_capacity;
+        cell->inherited = false;
+        return true;
+    }
+
+    if (index->num_retired >= index->retired_capacity) {
+        uint32_t retired_capacity = index->retired_capacity ? index->retired_capacity * 2 : 64;
+        ColorEntry** resized = realloc(index->retired, retired_capacity * sizeof(ColorEntry*));
+        if (!resized) return false;
+        index->retired = resized;
+        index->retired_capacity = retired_capacity;
+    }
+    ColorEntry* copy = malloc(new_capacity * sizeof(ColorEntry));
+    if (!copy) return false;
+    memcpy(copy, cell->entries, cell->count * sizeof(ColorEntry));
+    index->retired[index->num_retired++] = cell->entries;
+    cell->entries = copy;
+    cell->capacity = new_capacity;
+    cell->inherited = false;
+    return true;
+}
+
+bool update_bead_color_index(BeadCollection* collection) {
+    // Nothing new to add. Published catalog versions are always here, so
+    // concurrent readers never write to the grid.
+    BeadColorIndex* current = collection->color_index;
+    if (current && current->indexed_count >= collection->count) return true;
+    // A forked grid's cells grow on behalf of the fork
+    if (current && current->forked) return false;
+    if (!current) {
+        collection->color_index = calloc(1, sizeof(BeadColorIndex));
+        if (!collection->color_index) return false;
+    }
+
+    BeadColorIndex* index = collection->color_index;
+    for (; index->indexed_count < collection->count; index->indexed_count++) {
+        ColorEntry entry;
+        int cell_index[3];
+        color_to_lab(get_bead_at(collection, index->indexed_count)->color, entry.lab);
+        entry.slot = index->indexed_count;
+        lab_to_cell(entry.lab, cell_index);
+
+        ColorCell* cell = get_cell(index, cell_index[0], cell_index[1], cell_index[2]);
+        if (cell->count >= cell->capacity && !grow_cell(index, cell)) return false;
+        cell->entries[cell->count++] = entry;
+    }
+    return true;
+}
+
+BeadColorIndex* fork_bead_color_index(BeadColorIndex* index) {
+    if (!index || index->forked) return NULL;
+
+    BeadColorIndex* fork = malloc(sizeof(BeadColorIndex));
+    if (!fork) return NULL;
+    *fork = *index;
+    for (uint32_t i = 0; i < COLOR_CELL_COUNT; i++) fork->cells[i].inherited = true;
+    index->forked = true;
+    return fork;
+}
+
+void unfork_bead_color_index(BeadColorIndex* fork, BeadColorIndex* index) {
+    if (!fork || !index) return;
+
+    // Cells the fork copied or started are its own; retired buffers it added
+    // are still in use by index
+    for (uint32_t i = 0; i < COLOR_CELL_COUNT; i++) {
+        if (!fork->cells[i].inherited) free(fork->cells[i].entries);
+    }
+    index->retired = fork->retired;
+    index->retired_capacity = fork->retired_capacity;
+    index->forked = false;
+    free(fork);
+}
+
+void free_bead_color_index(BeadColorIndex* index) {
+    if (index) {
+        if (!index->forked) {
+            for (uint32_t i = 0; i < COLOR_CELL_COUNT; i++) free(index->cells[i].entries);
+            for (uint32_t i = 0; i < index->num_retired; i++) free(index->retired[i]);
+            free(index->retired);
+        }
+        free(index);
+    }
+}
+
+// Query state: the caller's buffer doubles as a max-heap on distance, so the
+// worst kept match sits at out[0]
+typedef struct {
+    BeadCollection* collection;
+    const BeadFilter* filter;
+    const char* category;         // Interned filter category
+    float lab[3];
+    float max_distance_squared;   // Only consider entries at most this far
+    bool prune;                   // Shrink max_distance_squared to the worst kept match
+    BeadColorMatch* out;
+    uint32_t capacity;
+    uint32_t count;               // Matches kept in out
+    uint32_t total;               // Matches seen, kept or not
+} ColorQuery;
+
+static bool match_worse(BeadColorMatch a, BeadColorMatch b) {
+    return a.delta_e > b.delta_e || (a.delta_e == b.delta_e && a.bead > b.bead);
+}
+
+static void keep_match(ColorQuery* query, BeadColorMatch match) {
+    BeadColorMatch* heap = query->out;
+    uint32_t i;
+    if (query->count < query->capacity) {
+        i = query->count++;
+        while (i > 0 && match_worse(match, heap[(i - 1) / 2])) {
+            heap[i] = heap[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap[i] = match;
+        return;
+    }
+    if (query->capacity == 0 || !match_worse(heap[0], match)) return;
+
+    i = 0;
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= query->count) break;
+        if (child + 1 < query->count && match_worse(heap[child + 1], heap[child])) child++;
+        if (!match_worse(heap[child], match)) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = match;
+}
+
+static bool matches_filter(const BeadDefinition* bead, const BeadFilter* filter, const char* category) {
+    return (filter->material < 0 || (int)bead->material == filter->material) &&
+           (filter->shape < 0 || (int)bead->shape == filter->shape) &&
+           (filter->finish < 0 || (int)bead->finish == filter->finish) &&
+           (filter->premium < 0 || (int)bead->is_premium == filter->premium) &&
+           (!filter->category || bead->category == category) &&
+           (!filter->match_size || (bead->size_mm >= filter->min_size_mm && bead->size_mm <= filter->max_size_mm));
+}
+
+static void visit_cell(ColorQuery* query, const ColorCell* cell) {
+    for (uint32_t i = 0; i < cell->count; i++) {
+        const ColorEntry* entry = &cell->entries[i];
+        float distance = distance_squared(entry->lab, query->lab);
+        if (distance > query->max_distance_squared) continue;
+
+        BeadDefinition* bead = get_bead_at(query->collection, entry->slot);
+        if (query->filter && !matches_filter(bead, query->filter, query->category)) continue;
+
+        query->total++;
+        BeadColorMatch match = { bead, sqrtf(distance) };
+        keep_match(query, match);
+        // Once the buffer is full nothing worse than its worst entry can get in
+        if (query->prune && query->count == query->capacity) {
+            query->max_distance_squared = query->out[0].delta_e * query->out[0].delta_e;
+        }
+    }
+}
+
+static int compare_matches(const void* a, const void* b) {
+    BeadColorMatch x = *(const BeadColorMatch*)a;
+    BeadColorMatch y = *(const BeadColorMatch*)b;
+    return match_worse(y, x) ? -1 : (match_worse(x, y) ? 1 : 0);
+}
+
+// Set up a query; false if nothing can match
+static bool begin_color_query(ColorQuery* query, BeadCollection* collection, Clay_Color color,
+                              const BeadFilter* filter, BeadColorMatch* out, uint32_t capacity) {
+    memset(query, 0, sizeof(*query));
+    if (!collection || !update_bead_color_index(collection)) return false;
+
+    query->collection = collection;
+    query->filter = filter;
+    query->out = out;
+    query->capacity = out ? capacity : 0;
+    query->max_distance_squared = INFINITY;
+    color_to_lab(color, query->lab);
+
+    // An unknown category matches nothing
+    if (filter && filter->category) {
+        query->category = string_arena_find(collection->strings, filter->category);
+        if (!query->category) return false;
+    }
+    return true;
+}
+
+static uint32_t finish_color_query(ColorQuery* query) {
+    qsort(query->out, query->count, sizeof(BeadColorMatch), compare_matches);
+    return query->count;
+}
+
+uint32_t find_nearest_color_beads(BeadCollection* collection, Clay_Color color, const BeadFilter* filter,
+                                  BeadColorMatch* out, uint32_t k) {
+    ColorQuery query;
+    if (!begin_color_query(&query, collection, color, filter, out, k) || query.capacity == 0) return 0;
+    query.prune = true;
+
+    int center[3];
+    lab_to_cell(query.lab, center);
+    int max_radius = COLOR_CELLS_AB;
+    BeadColorIndex* index = collection->color_index;
+
+    // Visit shells of cells at growing Chebyshev distance. Every entry in
+    // shell r is at least (r - 1) cells away, so stop once that exceeds the
+    // k-th best distance.
+    for (int r = 0; r <= max_radius; r++) {
+        if (query.count == k) {
+            float bound = (float)(r - 1) * COLOR_CELL_SIZE;
+            float worst = out[0].delta_e;
+            if (bound > 0.0f && bound > worst) break;
+        }
+        int l_low = center[0] - r, l_high = center[0] + r;
+        int a_low = center[1] - r, a_high = center[1] + r;
+        for (int l = l_low < 0 ? 0 : l_low; l <= l_high && l < COLOR_CELLS_L; l++) {
+            for (int a = a_low < 0 ? 0 : a_low; a <= a_high && a < COLOR_CELLS_AB; a++) {
+                bool on_face = (l == l_low || l == l_high || a == a_low || a == a_high);
+                // Cells strictly inside the shell in L and a only lie on its b faces
+                int step = on_face ? 1 : 2 * r;
+                for (int b = center[2] - r; b <= center[2] + r; b += step > 0 ? step : 1) {
+                    if (b < 0 || b >= COLOR_CELLS_AB) continue;
+                    visit_cell(&query, get_cell(index, l, a, b));
+                }
+            }
+        }
+    }
+    return finish_color_query(&query);
+}
+
+uint32_t find_beads_within_delta_e(BeadCollection* collection, Clay_Color color, float max_delta_e,
+                                   const BeadFilter* filter, BeadColorMatch* out, uint32_t capacity) {
+    ColorQuery query;
+    if (!(max_delta_e >= 0.0f) || !begin_color_query(&query, collection, color, filter, out, capacity)) return 0;
+    query.max_distance_squared = max_delta_e * max_delta_e;
+
+    // Every cell the ball around the query touches
+    int low[3], high[3];
+    float corner[3] = { query.lab[0] - max_delta_e, query.lab[1] - max_delta_e, query.lab[2] - max_delta_e };
+    lab_to_cell(corner, low);
+    corner[0] = query.lab[0] + max_delta_e;
+    corner[1] = query.lab[1] + max_delta_e;
+    corner[2] = query.lab[2] + max_delta_e;
+    lab_to_cell(corner, high);
+
+    BeadColorIndex* index = collection->color_index;
+    for (int l = low[0]; l <= high[0]; l++) {
+        for (int a = low[1]; a <= high[1]; a++) {
+            for (int b = low[2]; b <= high[2]; b++) {
+                visit_cell(&query, get_cell(index, l, a, b));
+            }
+        }
+    }
+    finish_color_query(&query);
+    return query.total;
+}
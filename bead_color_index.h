@@ -0,0 +1,44 @@
+#ifndef BEAD_COLOR_INDEX_H
+#define BEAD_COLOR_INDEX_H
+
+#include "bead.h"
+
+// A bead and its CIE76 color difference (Euclidean distance in CIELAB) from
+// the query color. A delta E around 2.3 is a just-noticeable difference.
+typedef struct {
+    BeadDefinition* bead;
+    float delta_e;
+} BeadColorMatch;
+
+// The k beads closest in color, nearest first. Only beads matching filter
+// (NULL for all) are considered. Returns how many matches were written.
+uint32_t find_nearest_color_beads(BeadCollection* collection, Clay_Color color, const BeadFilter* filter,
+                                  BeadColorMatch* out, uint32_t k);
+
+// Beads within max_delta_e of a color. Writes the closest `capacity` of them
+// to out, nearest first, and returns the total number within range.
+uint32_t find_beads_within_delta_e(BeadCollection* collection, Clay_Color color, float max_delta_e,
+                                   const BeadFilter* filter, BeadColorMatch* out, uint32_t capacity);
+
+// CIE76 color difference between two colors; alpha is ignored
+float get_color_delta_e(Clay_Color a, Clay_Color b);
+
+// Add beads appended since the last update to the color index, building it
+// on first use. add_bead_definition calls this once an index exists.
+bool update_bead_color_index(BeadCollection* collection);
+
+// Start the color index of the next version (called by clone_bead_collection).
+// The fork shares the grid cells: it appends past their ends in place and
+// copies a cell only when it must grow, so older versions keep reading their
+// own prefix. index stays readable but is not updated again, and freeing it
+// leaves the shared cells to the fork.
+BeadColorIndex* fork_bead_color_index(BeadColorIndex* index);
+
+// Undo fork_bead_color_index: free the fork and what it added, and give the
+// shared cells back to index
+void unfork_bead_color_index(BeadColorIndex* fork, BeadColorIndex* index);
+
+// Release a color index (called by free_bead_collection)
+void free_bead_color_index(BeadColorIndex* index);
+
+#endif // BEAD_COLOR_INDEX_H
@@ -0,0 +1,164 @@
+// Column scan kernels for BeadFilter
+#include "bead_filter.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BEAD_FILTER_X86 1
+#include <immintrin.h>
+#endif
+
+typedef void (*BeadFilterKernel)(const BeadSegment*, uint32_t, const BeadFilter*, uint64_t*);
+
+// Bits for the `length` (at most 64) beads starting at base
+static uint64_t filter_word(const BeadSegment* segment, uint32_t base, uint32_t length, const BeadFilter* filter) {
+    uint64_t word = 0;
+    for (uint32_t j = 0; j < length; j++) {
+        uint32_t i = base + j;
+        bool match = (filter->material < 0 || segment->materials[i] == filter->material) &&
+                     (filter->shape < 0 || segment->shapes[i] == filter->shape) &&
+                     (filter->finish < 0 || segment->finishes[i] == filter->finish) &&
+                     (filter->premium < 0 || segment->premium[i] == filter->premium) &&
+                     (!filter->match_size || (segment->sizes_mm[i] >= filter->min_size_mm &&
+                                              segment->sizes_mm[i] <= filter->max_size_mm));
+        word |= (uint64_t)match << j;
+    }
+    return word;
+}
+
+static void filter_scalar(const BeadSegment* segment, uint32_t count, const BeadFilter* filter, uint64_t* out_bits) {
+    for (uint32_t base = 0; base < count; base += 64) {
+        out_bits[base / 64] = filter_word(segment, base, 64, filter);
+    }
+}
+
+#ifdef BEAD_FILTER_X86
+
+// 16 beads per step: byte compares for the enum columns, 4-wide float compares for size
+__attribute__((target("sse2")))
+static void filter_sse2(const BeadSegment* segment, uint32_t count, const BeadFilter* filter, uint64_t* out_bits) {
+    const __m128i material = _mm_set1_epi8((char)filter->material);
+    const __m128i shape = _mm_set1_epi8((char)filter->shape);
+    const __m128i finish = _mm_set1_epi8((char)filter->finish);
+    const __m128i premium = _mm_set1_epi8((char)filter->premium);
+    const __m128 min_size = _mm_set1_ps(filter->min_size_mm);
+    const __m128 max_size = _mm_set1_ps(filter->max_size_mm);
+
+    for (uint32_t base = 0; base < count; base += 64) {
+        uint64_t word = 0;
+        for (uint32_t j = 0; j < 64; j += 16) {
+            uint32_t i = base + j;
+            __m128i mask = _mm_set1_epi8(-1);
+            if (filter->material >= 0) {
+                mask = _mm_and_si128(mask, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(segment->materials + i)), material));
+            }
+            if (filter->shape >= 0) {
+                mask = _mm_and_si128(mask, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(segment->shapes + i)), shape));
+            }
+            if (filter->finish >= 0) {
+                mask = _mm_and_si128(mask, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(segment->finishes + i)), finish));
+            }
+            if (filter->premium >= 0) {
+                mask = _mm_and_si128(mask, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(segment->premium + i)), premium));
+            }
+            uint64_t bits = (uint32_t)_mm_movemask_epi8(mask);
+
+            if (filter->match_size) {
+                uint64_t size_bits = 0;
+                for (uint32_t k = 0; k < 16; k += 4) {
+                    __m128 sizes = _mm_loadu_ps(segment->sizes_mm + i + k);
+                    __m128 in_range = _mm_and_ps(_mm_cmpge_ps(sizes, min_size), _mm_cmple_ps(sizes, max_size));
+                    size_bits |= (uint64_t)_mm_movemask_ps(in_range) << k;
+                }
+                bits &= size_bits;
+            }
+            word |= bits << j;
+        }
+        out_bits[base / 64] = word;
+    }
+}
+
+// 32 beads per step with 256-bit registers
+__attribute__((target("avx2")))
+static void filter_avx2(const BeadSegment* segment, uint32_t count, const BeadFilter* filter, uint64_t* out_bits) {
+    const __m256i material = _mm256_set1_epi8((char)filter->material);
+    const __m256i shape = _mm256_set1_epi8((char)filter->shape);
+    const __m256i finish = _mm256_set1_epi8((char)filter->finish);
+    const __m256i premium = _mm256_set1_epi8((char)filter->premium);
+    const __m256 min_size = _mm256_set1_ps(filter->min_size_mm);
+    const __m256 max_size = _mm256_set1_ps(filter->max_size_mm);
+
+    for (uint32_t base = 0; base < count; base += 64) {
+        uint64_t word = 0;
+        for (uint32_t j = 0; j < 64; j += 32) {
+            uint32_t i = base + j;
+            __m256i mask = _mm256_set1_epi8(-1);
+            if (filter->material >= 0) {
+                mask = _mm256_and_si256(mask, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(segment->materials + i)), material));
+            }
+            if (filter->shape >= 0) {
+                mask = _mm256_and_si256(mask, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(segment->shapes + i)), shape));
+            }
+            if (filter->finish >= 0) {
+                mask = _mm256_and_si256(mask, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(segment->finishes + i)), finish));
+            }
+            if (filter->premium >= 0) {
+                mask = _mm256_and_si256(mask, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(segment->premium + i)), premium));
+            }
+            uint64_t bits = (uint32_t)_mm256_movemask_epi8(mask);
+
+            if (filter->match_size) {
+                uint64_t size_bits = 0;
+                for (uint32_t k = 0; k < 32; k += 8) {
+                    __m256 sizes = _mm256_loadu_ps(segment->sizes_mm + i + k);
+                    __m256 in_range = _mm256_and_ps(_mm256_cmp_ps(sizes, min_size, _CMP_GE_OQ),
+                                                    _mm256_cmp_ps(sizes, max_size, _CMP_LE_OQ));
+                    size_bits |= (uint64_t)_mm256_movemask_ps(in_range) << k;
+                }
+                bits &= size_bits;
+            }
+            word |= bits << j;
+        }
+        out_bits[base / 64] = word;
+    }
+}
+
+#endif // BEAD_FILTER_X86
+
+static BeadFilterKernel selected_kernel = filter_scalar;
+static const char* selected_kernel_name = "scalar";
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+
+// Pick the widest kernel the CPU supports
+static void select_kernel(void) {
+#ifdef BEAD_FILTER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        selected_kernel = filter_avx2;
+        selected_kernel_name = "avx2";
+    } else if (__builtin_cpu_supports("sse2")) {
+        selected_kernel = filter_sse2;
+        selected_kernel_name = "sse2";
+    }
+#endif
+}
+
+// Pool workers may make the first call at the same time
+static BeadFilterKernel get_kernel(void) {
+    pthread_once(&kernel_once, select_kernel);
+    return selected_kernel;
+}
+
+void filter_bead_segment(const BeadSegment* segment, uint32_t count, const BeadFilter* filter, uint64_t* out_bits) {
+    // Kernels read whole words of 64 beads. The slots past count may belong to
+    // a newer catalog version that is still being written, so the last
+    // partial word is evaluated bead by bead.
+    uint32_t whole = count & ~63u;
+    if (whole > 0) get_kernel()(segment, whole, filter, out_bits);
+    if (whole < count) out_bits[whole / 64] = filter_word(segment, whole, count - whole, filter);
+}
+
+const char* get_bead_filter_kernel_name(void) {
+    get_kernel();
+    return selected_kernel_name;
+}
@@ -0,0 +1,15 @@
+#ifndef BEAD_FILTER_H
+#define BEAD_FILTER_H
+
+#include "bead.h"
+
+// Evaluate a filter over the first count beads of a segment, writing one bit
+// per bead to out_bits. Slots past count are not read, and their bits in the
+// last word are zero. Uses AVX2 or SSE2 when the CPU has them, scalar code
+// otherwise.
+void filter_bead_segment(const BeadSegment* segment, uint32_t count, const BeadFilter* filter, uint64_t* out_bits);
+
+// Name of the kernel filter_bead_segment dispatches to ("avx2", "sse2", "scalar")
+const char* get_bead_filter_kernel_name(void);
+
+#endif // BEAD_FILTER_H
@@ -0,0 +1,676 @@
+// Streaming supplier feed import: chunked reads, parallel parsing, ordered inserts
+#include "bead_import.h"
+#include "bead_parallel.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_IMPORT_THREADS 64
+#define MAX_IMPORT_COLUMNS 64     // Further CSV columns are ignored
+
+typedef enum {
+    IMPORT_COLUMN_IGNORED,
+    IMPORT_COLUMN_ID,
+    IMPORT_COLUMN_NAME,
+    IMPORT_COLUMN_DESCRIPTION,
+    IMPORT_COLUMN_MATERIAL,
+    IMPORT_COLUMN_SHAPE,
+    IMPORT_COLUMN_FINISH,
+    IMPORT_COLUMN_COLOR,
+    IMPORT_COLUMN_SIZE,
+    IMPORT_COLUMN_CATEGORY,
+    IMPORT_COLUMN_PREMIUM,
+    IMPORT_COLUMN_IMAGE_ID
+} ImportColumn;
+
+static const struct {
+    const char* name;
+    ImportColumn column;
+} column_names[] = {
+    { "id", IMPORT_COLUMN_ID },
+    { "name", IMPORT_COLUMN_NAME },
+    { "description", IMPORT_COLUMN_DESCRIPTION },
+    { "material", IMPORT_COLUMN_MATERIAL },
+    { "shape", IMPORT_COLUMN_SHAPE },
+    { "finish", IMPORT_COLUMN_FINISH },
+    { "color", IMPORT_COLUMN_COLOR },
+    { "size_mm", IMPORT_COLUMN_SIZE },
+    { "size", IMPORT_COLUMN_SIZE },
+    { "category", IMPORT_COLUMN_CATEGORY },
+    { "premium", IMPORT_COLUMN_PREMIUM },
+    { "is_premium", IMPORT_COLUMN_PREMIUM },
+    { "image_id", IMPORT_COLUMN_IMAGE_ID }
+};
+
+typedef enum {
+    ROW_BLANK,
+    ROW_BEAD,
+    ROW_SKIPPED
+} RowResult;
+
+// A block of whole rows. Parsing rewrites [start, end) in place, and the
+// parsed beads point into it until they are inserted.
+typedef struct {
+    char* data;
+    size_t capacity;
+    size_t length;                // Bytes read into data
+    size_t start;                 // First byte to parse
+    size_t end;                   // End of the last whole row; [end, length) carries over
+    BeadDefinition* beads;
+    uint32_t num_beads;
+    uint32_t beads_capacity;
+    uint32_t rows;
+    uint32_t skipped;
+    bool parsed;
+    bool failed;                  // Ran out of memory while parsing
+} ImportChunk;
+
+typedef struct {
+    BeadFeedFormat format;
+    ImportColumn columns[MAX_IMPORT_COLUMNS];  // CSV column mapping from the header
+    uint32_t num_columns;
+    size_t chunk_bytes;
+
+    // Chunk n lives in chunks[n % num_chunks]. The reader fills chunks in
+    // order, workers claim them in order, and the reader inserts them in order.
+    ImportChunk* chunks;
+    uint32_t num_chunks;
+    uint64_t filled;              // Chunks handed to the workers
+    uint64_t claimed;             // Chunks taken by a worker
+    bool finished;                // No more chunks will be filled
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t chunk_parsed;
+} Importer;
+
+static bool equals_ignore_case(const char* a, const char* b) {
+    while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+        a++;
+        b++;
+    }
+    return tolower((unsigned char)*a) == tolower((unsigned char)*b);
+}
+
+static ImportColumn lookup_column(const char* name) {
+    for (size_t i = 0; i < sizeof(column_names) / sizeof(column_names[0]); i++) {
+        if (equals_ignore_case(name, column_names[i].name)) return column_names[i].column;
+    }
+    return IMPORT_COLUMN_IGNORED;
+}
+
+// Strip surrounding whitespace in place
+static char* trim(char* value) {
+    while (isspace((unsigned char)*value)) value++;
+    char* end = value + strlen(value);
+    while (end > value && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return value;
+}
+
+static bool parse_unsigned(const char* value, uint32_t limit, uint32_t* out) {
+    char* end;
+    unsigned long number = strtoul(value, &end, 10);
+    if (end == value || *end || number >= limit || !isdigit((unsigned char)*value)) return false;
+    *out = (uint32_t)number;
+    return true;
+}
+
+static int parse_material(const char* value) {
+    for (int i = 0; i < BEAD_MATERIAL_COUNT; i++) {
+        if (equals_ignore_case(value, get_material_name((BeadMaterial)i))) return i;
+    }
+    uint32_t number;
+    return parse_unsigned(value, BEAD_MATERIAL_COUNT, &number) ? (int)number : -1;
+}
+
+static int parse_shape(const char* value) {
+    for (int i = 0; i < BEAD_SHAPE_COUNT; i++) {
+        if (equals_ignore_case(value, get_shape_name((BeadShape)i))) return i;
+    }
+    uint32_t number;
+    return parse_unsigned(value, BEAD_SHAPE_COUNT, &number) ? (int)number : -1;
+}
+
+static int parse_finish(const char* value) {
+    for (int i = 0; i < BEAD_FINISH_COUNT; i++) {
+        if (equals_ignore_case(value, get_finish_name((BeadFinish)i))) return i;
+    }
+    uint32_t number;
+    return parse_unsigned(value, BEAD_FINISH_COUNT, &number) ? (int)number : -1;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// "#RRGGBB" or "#RRGGBBAA", the '#' being optional
+static bool parse_color(const char* value, Clay_Color* color) {
+    if (*value == '#') value++;
+    size_t length = strlen(value);
+    if (length != 6 && length != 8) return false;
+
+    float channels[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    for (size_t i = 0; i < length / 2; i++) {
+        int high = hex_digit(value[2 * i]);
+        int low = hex_digit(value[2 * i + 1]);
+        if (high < 0 || low < 0) return false;
+        channels[i] = (float)(high * 16 + low) / 255.0f;
+    }
+    *color = (Clay_Color){ channels[0], channels[1], channels[2], channels[3] };
+    return true;
+}
+
+static bool parse_flag(const char* value, bool* out) {
+    if (equals_ignore_case(value, "true") || equals_ignore_case(value, "yes") || strcmp(value, "1") == 0) {
+        *out = true;
+    } else if (equals_ignore_case(value, "false") || equals_ignore_case(value, "no") || strcmp(value, "0") == 0) {
+        *out = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Store one field of a row in bead. Text fields point at value, which must
+// stay valid until the bead is inserted. Returns false for unmappable values.
+static bool apply_field(BeadDefinition* bead, ImportColumn column, char* value) {
+    if (!value || column == IMPORT_COLUMN_IGNORED) return true;
+    value = trim(value);
+    if (!*value) return true;
+
+    int number;
+    char* end;
+    switch (column) {
+        case IMPORT_COLUMN_ID: bead->id = value; return true;
+        case IMPORT_COLUMN_NAME: bead->name = value; return true;
+        case IMPORT_COLUMN_DESCRIPTION: bead->description = value; return true;
+        case IMPORT_COLUMN_CATEGORY: bead->category = value; return true;
+        case IMPORT_COLUMN_MATERIAL:
+            if ((number = parse_material(value)) < 0) return false;
+            bead->material = (BeadMaterial)number;
+            return true;
+        case IMPORT_COLUMN_SHAPE:
+            if ((number = parse_shape(value)) < 0) return false;
+            bead->shape = (BeadShape)number;
+            return true;
+        case IMPORT_COLUMN_FINISH:
+            if ((number = parse_finish(value)) < 0) return false;
+            bead->finish = (BeadFinish)number;
+            return true;
+        case IMPORT_COLUMN_COLOR: return parse_color(value, &bead->color);
+        case IMPORT_COLUMN_SIZE:
+            bead->size_mm = strtof(value, &end);
+            return end != value && !*end;
+        case IMPORT_COLUMN_PREMIUM: return parse_flag(value, &bead->is_premium);
+        case IMPORT_COLUMN_IMAGE_ID: return parse_unsigned(value, UINT32_MAX, &bead->image_id);
+        default: return true;
+    }
+}
+
+// Split the CSV row at *cursor into fields, unquoting them in place, and move
+// *cursor past the row. Returns the number of fields stored (at most max_fields).
+static uint32_t parse_csv_row(char** cursor, char* end, char** fields, uint32_t max_fields) {
+    char* p = *cursor;
+    uint32_t count = 0;
+    for (;;) {
+        char* start = p;
+        char* out = p;
+        if (p < end && *p == '"') {
+            p++;
+            while (p < end) {
+                if (*p == '"') {
+                    if (p + 1 < end && p[1] == '"') {
+                        *out++ = '"';
+                        p += 2;
+                        continue;
+                    }
+                    p++;
+                    break;
+                }
+                *out++ = *p++;
+            }
+            // Anything between the closing quote and the delimiter is dropped
+            while (p < end && *p != ',' && *p != '\n') p++;
+        } else {
+            while (p < end && *p != ',' && *p != '\n') p++;
+            out = p;
+            if (out > start && out[-1] == '\r') out--;
+        }
+
+        char delimiter = p < end ? *p : '\n';
+        *out = '\0';
+        if (count < max_fields) fields[count] = start;
+        count++;
+        if (p < end) p++;
+        if (delimiter == '\n') break;
+    }
+    *cursor = p;
+    return count < max_fields ? count : max_fields;
+}
+
+static RowResult parse_csv_record(const Importer* importer, char** cursor, char* end, BeadDefinition* bead) {
+    char* fields[MAX_IMPORT_COLUMNS];
+    uint32_t count = parse_csv_row(cursor, end, fields, MAX_IMPORT_COLUMNS);
+    if (count == 1 && !*trim(fields[0])) return ROW_BLANK;
+
+    if (count > importer->num_columns) count = importer->num_columns;
+    for (uint32_t i = 0; i < count; i++) {
+        if (!apply_field(bead, importer->columns[i], fields[i])) return ROW_SKIPPED;
+    }
+    return ROW_BEAD;
+}
+
+static char* skip_space(char* p, char* end) {
+    while (p < end && isspace((unsigned char)*p)) p++;
+    return p;
+}
+
+static char* encode_utf8(char* out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        *out++ = (char)codepoint;
+    } else if (codepoint < 0x800) {
+        *out++ = (char)(0xC0 | (codepoint >> 6));
+        *out++ = (char)(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        *out++ = (char)(0xE0 | (codepoint >> 12));
+        *out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (codepoint & 0x3F));
+    } else {
+        *out++ = (char)(0xF0 | (codepoint >> 18));
+        *out++ = (char)(0x80 | ((codepoint >> 12) & 0x3F));
+        *out++ = (char)(0x80 | ((codepoint >> 6) & 0x3F));
+        *out++ = (char)(0x80 | (codepoint & 0x3F));
+    }
+    return out;
+}
+
+static bool parse_hex4(const char* p, const char* end, uint32_t* out) {
+    if (end - p < 4) return false;
+    *out = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hex_digit(p[i]);
+        if (digit < 0) return false;
+        *out = *out * 16 + (uint32_t)digit;
+    }
+    return true;
+}
+
+// Decode the JSON string whose opening quote precedes p, in place. Returns the
+// position after the closing quote, or NULL if the string is malformed.
+static char* parse_json_string(char* p, char* end, char** value) {
+    char* out = p;
+    *value = p;
+    while (p < end) {
+        char c = *p++;
+        if (c == '"') {
+            *out = '\0';
+            return p;
+        }
+        if (c != '\\') {
+            *out++ = c;
+            continue;
+        }
+        if (p >= end) return NULL;
+        switch (*p++) {
+            case '"': *out++ = '"'; break;
+            case '\\': *out++ = '\\'; break;
+            case '/': *out++ = '/'; break;
+            case 'b': *out++ = '\b'; break;
+            case 'f': *out++ = '\f'; break;
+            case 'n': *out++ = '\n'; break;
+            case 'r': *out++ = '\r'; break;
+            case 't': *out++ = '\t'; break;
+            case 'u': {
+                uint32_t codepoint, low;
+                if (!parse_hex4(p, end, &codepoint)) return NULL;
+                p += 4;
+                if (codepoint >= 0xD800 && codepoint < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u' &&
+                    parse_hex4(p + 2, end, &low) && low >= 0xDC00 && low < 0xE000) {
+                    codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                    p += 6;
+                }
+                out = encode_utf8(out, codepoint);
+                break;
+            }
+            default: return NULL;
+        }
+    }
+    return NULL;
+}
+
+// Skip a nested object or array starting at p
+static char* skip_json_nested(char* p, char* end) {
+    int depth = 0;
+    while (p < end) {
+        char c = *p++;
+        if (c == '"') {
+            while (p < end && *p != '"') p += (*p == '\\') ? 2 : 1;
+            if (p >= end) return NULL;
+            p++;
+        } else if (c == '{' || c == '[') {
+            depth++;
+        } else if ((c == '}' || c == ']') && --depth == 0) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+// Parse one line holding a flat JSON object. Strings are decoded in place;
+// numbers and literals are passed to apply_field as text, null as missing.
+static RowResult parse_ndjson_record(char** cursor, char* end, BeadDefinition* bead) {
+    char* line_end = memchr(*cursor, '\n', (size_t)(end - *cursor));
+    if (!line_end) line_end = end;
+    char* p = skip_space(*cursor, line_end);
+    *cursor = line_end < end ? line_end + 1 : end;
+    if (p == line_end) return ROW_BLANK;
+    if (*p++ != '{') return ROW_SKIPPED;
+
+    RowResult result = ROW_BEAD;
+    p = skip_space(p, line_end);
+    if (p < line_end && *p == '}') return result;
+    for (;;) {
+        char* key;
+        char* value = NULL;
+        if (p >= line_end || *p != '"' || !(p = parse_json_string(p + 1, line_end, &key))) return ROW_SKIPPED;
+        p = skip_space(p, line_end);
+        if (p >= line_end || *p != ':') return ROW_SKIPPED;
+        p = skip_space(p + 1, line_end);
+        if (p >= line_end) return ROW_SKIPPED;
+
+        char delimiter;
+        if (*p == '"') {
+            if (!(p = parse_json_string(p + 1, line_end, &value))) return ROW_SKIPPED;
+            p = skip_space(p, line_end);
+            delimiter = p < line_end ? *p : '\0';
+        } else if (*p == '{' || *p == '[') {
+            if (!(p = skip_json_nested(p, line_end))) return ROW_SKIPPED;
+            p = skip_space(p, line_end);
+            delimiter = p < line_end ? *p : '\0';
+        } else {
+            value = p;
+            while (p < line_end && *p != ',' && *p != '}' && !isspace((unsigned char)*p)) p++;
+            char* literal_end = p;
+            p = skip_space(p, line_end);
+            delimiter = p < line_end ? *p : '\0';
+            *literal_end = '\0';  // line_end is the newline or a spare byte, so this is in bounds
+            if (strcmp(value, "null") == 0) value = NULL;
+        }
+
+        if (result == ROW_BEAD && !apply_field(bead, lookup_column(key), value)) result = ROW_SKIPPED;
+        if (delimiter == '}') return result;
+        if (delimiter != ',') return ROW_SKIPPED;
+        p = skip_space(p + 1, line_end);
+    }
+}
+
+static void parse_chunk(const Importer* importer, ImportChunk* chunk) {
+    char* p = chunk->data + chunk->start;
+    char* end = chunk->data + chunk->end;
+    chunk->num_beads = 0;
+    chunk->rows = 0;
+    chunk->skipped = 0;
+    chunk->failed = false;
+
+    while (p < end) {
+        BeadDefinition bead = {0};
+        bead.color = (Clay_Color){ 1.0f, 1.0f, 1.0f, 1.0f };
+        RowResult result = importer->format == BEAD_FEED_CSV
+            ? parse_csv_record(importer, &p, end, &bead)
+            : parse_ndjson_record(&p, end, &bead);
+        if (result == ROW_BLANK) continue;
+
+        chunk->rows++;
+        if (result == ROW_SKIPPED || !bead.id) {
+            chunk->skipped++;
+            continue;
+        }
+        if (chunk->num_beads >= chunk->beads_capacity) {
+            uint32_t new_capacity = chunk->beads_capacity ? chunk->beads_capacity * 2 : 1024;
+            BeadDefinition* resized = realloc(chunk->beads, new_capacity * sizeof(BeadDefinition));
+            if (!resized) {
+                chunk->failed = true;
+                return;
+            }
+            chunk->beads = resized;
+            chunk->beads_capacity = new_capacity;
+        }
+        chunk->beads[chunk->num_beads++] = bead;
+    }
+}
+
+static void* import_worker(void* arg) {
+    Importer* importer = arg;
+    pthread_mutex_lock(&importer->lock);
+    for (;;) {
+        while (importer->claimed == importer->filled && !importer->finished) {
+            pthread_cond_wait(&importer->work_ready, &importer->lock);
+        }
+        if (importer->claimed == importer->filled) break;
+
+        ImportChunk* chunk = &importer->chunks[importer->claimed++ % importer->num_chunks];
+        pthread_mutex_unlock(&importer->lock);
+        parse_chunk(importer, chunk);
+        pthread_mutex_lock(&importer->lock);
+        chunk->parsed = true;
+        pthread_cond_broadcast(&importer->chunk_parsed);
+    }
+    pthread_mutex_unlock(&importer->lock);
+    return NULL;
+}
+
+// Offset just past the last complete row in data, or 0 if there is none. CSV
+// rows only end at newlines outside quoted fields.
+static size_t find_rows_end(BeadFeedFormat format, const char* data, size_t length) {
+    if (format == BEAD_FEED_CSV && memchr(data, '"', length)) {
+        size_t rows_end = 0;
+        bool quoted = false;
+        for (size_t i = 0; i < length; i++) {
+            if (data[i] == '"') quoted = !quoted;
+            else if (data[i] == '\n' && !quoted) rows_end = i + 1;
+        }
+        return rows_end;
+    }
+    for (size_t i = length; i > 0; i--) {
+        if (data[i - 1] == '\n') return i;
+    }
+    return 0;
+}
+
+static bool reserve_chunk(ImportChunk* chunk, size_t capacity) {
+    if (chunk->capacity >= capacity) return true;
+    char* resized = realloc(chunk->data, capacity);
+    if (!resized) return false;
+    chunk->data = resized;
+    chunk->capacity = capacity;
+    return true;
+}
+
+// Start a chunk with the rows carried over from the previous one, then read
+// until it holds at least one whole row or the file ends
+static bool fill_chunk(Importer* importer, ImportChunk* chunk, const ImportChunk* previous, FILE* file,
+                       bool* eof, uint64_t* bytes_read) {
+    size_t carry = previous ? previous->length - previous->end : 0;
+    // One spare byte lets the parsers terminate a final row that lacks a newline
+    if (!reserve_chunk(chunk, carry + importer->chunk_bytes + 1)) return false;
+    if (carry) memcpy(chunk->data, previous->data + previous->end, carry);
+    chunk->length = carry;
+    chunk->start = 0;
+
+    for (;;) {
+        size_t wanted = chunk->capacity - chunk->length - 1;
+        size_t got = fread(chunk->data + chunk->length, 1, wanted, file);
+        chunk->length += got;
+        *bytes_read += got;
+        if (got < wanted) {
+            if (ferror(file)) return false;
+            *eof = true;
+        }
+
+        chunk->end = find_rows_end(importer->format, chunk->data, chunk->length);
+        if (*eof) chunk->end = chunk->length;
+        if (chunk->end > 0 || *eof) return true;
+        // A single row longer than the chunk: keep reading into a bigger buffer
+        if (!reserve_chunk(chunk, chunk->capacity * 2)) return false;
+    }
+}
+
+// Map the CSV header at the start of the first chunk
+static bool parse_csv_header(Importer* importer, ImportChunk* chunk) {
+    char* fields[MAX_IMPORT_COLUMNS];
+    char* p = chunk->data + chunk->start;
+    bool has_id = false;
+    importer->num_columns = parse_csv_row(&p, chunk->data + chunk->end, fields, MAX_IMPORT_COLUMNS);
+    for (uint32_t i = 0; i < importer->num_columns; i++) {
+        importer->columns[i] = lookup_column(trim(fields[i]));
+        has_id |= importer->columns[i] == IMPORT_COLUMN_ID;
+    }
+    chunk->start = (size_t)(p - chunk->data);
+    return has_id;
+}
+
+static BeadFeedFormat detect_format(const char* path, FILE* file) {
+    const char* extension = strrchr(path, '.');
+    if (extension) {
+        if (equals_ignore_case(extension, ".csv")) return BEAD_FEED_CSV;
+        if (equals_ignore_case(extension, ".ndjson") || equals_ignore_case(extension, ".jsonl") ||
+            equals_ignore_case(extension, ".json")) {
+            return BEAD_FEED_NDJSON;
+        }
+    }
+
+    int c;
+    while ((c = fgetc(file)) != EOF && (isspace(c) || c == 0xEF || c == 0xBB || c == 0xBF)) {}
+    rewind(file);
+    return c == '{' ? BEAD_FEED_NDJSON : BEAD_FEED_CSV;
+}
+
+BeadImportOptions make_bead_import_options(void) {
+    BeadImportOptions options = {0};
+    options.format = BEAD_FEED_AUTO;
+    return options;
+}
+
+// Wait for the oldest outstanding chunk, insert its beads and report progress
+static bool insert_next_chunk(Importer* importer, uint64_t sequence, BeadCollection* collection,
+                              const BeadImportOptions* options, BeadImportProgress* progress) {
+    ImportChunk* chunk = &importer->chunks[sequence % importer->num_chunks];
+    pthread_mutex_lock(&importer->lock);
+    while (!chunk->parsed) pthread_cond_wait(&importer->chunk_parsed, &importer->lock);
+    pthread_mutex_unlock(&importer->lock);
+    if (chunk->failed) return false;
+
+    uint32_t added = add_bead_definitions(collection, chunk->beads, chunk->num_beads);
+    progress->rows += chunk->rows;
+    progress->skipped += chunk->skipped;
+    progress->imported += added;
+    if (options->on_progress) options->on_progress(progress, options->user_data);
+    return added == chunk->num_beads;
+}
+
+bool import_bead_feed(BeadCollection* collection, const char* path, const BeadImportOptions* options,
+                      BeadImportProgress* progress) {
+    BeadImportOptions defaults = make_bead_import_options();
+    BeadImportProgress counts = {0};
+    if (!options) options = &defaults;
+    if (progress) *progress = counts;
+    if (!collection || !path) return false;
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        counts.total_bytes = size > 0 ? (uint64_t)size : 0;
+    }
+    rewind(file);
+
+    Importer importer;
+    memset(&importer, 0, sizeof(importer));
+    importer.format = options->format == BEAD_FEED_AUTO ? detect_format(path, file) : options->format;
+    importer.chunk_bytes = options->chunk_bytes ? options->chunk_bytes : BEAD_IMPORT_CHUNK_BYTES;
+
+    uint32_t num_threads = options->num_threads ? options->num_threads : get_bead_cpu_count();
+    if (num_threads > MAX_IMPORT_THREADS) num_threads = MAX_IMPORT_THREADS;
+    importer.num_chunks = num_threads * 2;
+    importer.chunks = calloc(importer.num_chunks, sizeof(ImportChunk));
+    if (!importer.chunks) {
+        fclose(file);
+        return false;
+    }
+    pthread_mutex_init(&importer.lock, NULL);
+    pthread_cond_init(&importer.work_ready, NULL);
+    pthread_cond_init(&importer.chunk_parsed, NULL);
+
+    // Without any worker the reader parses each chunk itself
+    pthread_t workers[MAX_IMPORT_THREADS];
+    uint32_t num_workers = 0;
+    while (num_workers < num_threads &&
+           pthread_create(&workers[num_workers], NULL, import_worker, &importer) == 0) {
+        num_workers++;
+    }
+
+    bool ok = true;
+    bool eof = false;
+    uint64_t sequence = 0;
+    uint64_t inserted = 0;
+    while (ok && !eof) {
+        if (sequence - inserted == importer.num_chunks) {
+            ok = insert_next_chunk(&importer, inserted++, collection, options, &counts);
+            if (!ok) break;
+        }
+
+        ImportChunk* chunk = &importer.chunks[sequence % importer.num_chunks];
+        const ImportChunk* previous = sequence ? &importer.chunks[(sequence - 1) % importer.num_chunks] : NULL;
+        if (!fill_chunk(&importer, chunk, previous, file, &eof, &counts.bytes_read)) {
+            ok = false;
+            break;
+        }
+        if (sequence == 0) {
+            if (chunk->length >= 3 && memcmp(chunk->data, "\xEF\xBB\xBF", 3) == 0) chunk->start = 3;
+            if (importer.format == BEAD_FEED_CSV && chunk->end > chunk->start &&
+                !parse_csv_header(&importer, chunk)) {
+                ok = false;
+                break;
+            }
+        }
+
+        pthread_mutex_lock(&importer.lock);
+        chunk->parsed = false;
+        importer.filled++;
+        pthread_cond_signal(&importer.work_ready);
+        pthread_mutex_unlock(&importer.lock);
+        if (num_workers == 0) {
+            importer.claimed++;
+            parse_chunk(&importer, chunk);
+            chunk->parsed = true;
+        }
+        sequence++;
+    }
+    while (ok && inserted < sequence) {
+        ok = insert_next_chunk(&importer, inserted++, collection, options, &counts);
+    }
+
+    pthread_mutex_lock(&importer.lock);
+    importer.finished = true;
+    pthread_cond_broadcast(&importer.work_ready);
+    pthread_mutex_unlock(&importer.lock);
+    for (uint32_t i = 0; i < num_workers; i++) pthread_join(workers[i], NULL);
+
+    for (uint32_t i = 0; i < importer.num_chunks; i++) {
+        free(importer.chunks[i].data);
+        free(importer.chunks[i].beads);
+    }
+    free(importer.chunks);
+    pthread_mutex_destroy(&importer.lock);
+    pthread_cond_destroy(&importer.work_ready);
+    pthread_cond_destroy(&importer.chunk_parsed);
+    fclose(file);
+
+    if (progress) *progress = counts;
+    return ok;
+}
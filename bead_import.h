@@ -0,0 +1,57 @@
+#ifndef BEAD_IMPORT_H
+#define BEAD_IMPORT_H
+
+#include "bead.h"
+
+// Supplier feed formats. CSV needs a header row naming its columns; NDJSON
+// holds one flat JSON object per line. Both use the same field names:
+//
+//   id, name, description, material, shape, finish, color, size_mm (or size),
+//   category, premium (or is_premium), image_id
+//
+// Names are matched case-insensitively and unknown columns are ignored.
+// material, shape and finish take the names from get_material_name() etc. or
+// their numeric values, color is "#RRGGBB" or "#RRGGBBAA", and premium is
+// true/false, yes/no or 1/0. Missing fields are zero, except color which
+// defaults to opaque white. Rows without an id, or with a value that cannot be
+// mapped, are skipped.
+typedef enum {
+    BEAD_FEED_AUTO,     // Pick by extension (.csv, .ndjson, .jsonl, .json), else by the first byte
+    BEAD_FEED_CSV,
+    BEAD_FEED_NDJSON
+} BeadFeedFormat;
+
+typedef struct {
+    uint64_t bytes_read;
+    uint64_t total_bytes;   // Size of the feed, 0 if unknown
+    uint64_t rows;          // Data rows parsed so far, header excluded
+    uint64_t imported;      // Rows added to the collection
+    uint64_t skipped;       // Rows that could not be mapped to a bead
+} BeadImportProgress;
+
+typedef void (*BeadImportProgressFn)(const BeadImportProgress* progress, void* user_data);
+
+// Default chunk size; memory use is about 2 * num_threads chunks
+#define BEAD_IMPORT_CHUNK_BYTES (4u << 20)
+
+typedef struct {
+    BeadFeedFormat format;
+    uint32_t num_threads;           // Parser threads, 0 for one per core
+    uint32_t chunk_bytes;           // Bytes read at a time, 0 for BEAD_IMPORT_CHUNK_BYTES
+    BeadImportProgressFn on_progress;  // Called on the importing thread after each chunk
+    void* user_data;
+} BeadImportOptions;
+
+// Default options: detect the format, one parser per core, no progress callback
+BeadImportOptions make_bead_import_options(void);
+
+// Stream a feed into the collection. The file is read in chunks on the calling
+// thread, parsed on a worker pool and inserted in file order, so rows keep
+// their order and the first row with a given id wins as with add_bead_definition.
+// Returns false on read or allocation errors, or a CSV header without an id
+// column; rows imported before an error stay in the collection. progress (may
+// be NULL) receives the final counts.
+bool import_bead_feed(BeadCollection* collection, const char* path, const BeadImportOptions* options,
+                      BeadImportProgress* progress);
+
+#endif // BEAD_IMPORT_H
@@ -0,0 +1,148 @@
+// Worker pool for partitioned catalog queries
+#include "bead_parallel.h"
+#include <pthread.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static struct {
+    pthread_mutex_t run_lock;     // Held for a whole run_bead_parallel call
+    pthread_mutex_t lock;         // Guards the job fields below
+    pthread_cond_t job_ready;
+    pthread_cond_t job_done;
+    pthread_t workers[MAX_BEAD_PARALLEL_THREADS];
+    uint32_t num_workers;
+    bool stopping;
+
+    // Current job: tasks [0, num_tasks), handed out in order
+    void (*task)(uint32_t index, void* context);
+    void* context;
+    uint32_t num_tasks;
+    uint32_t next_task;
+    uint32_t finished_tasks;
+
+    uint32_t threshold;
+    uint32_t num_threads;         // Configured thread count, 0 for one per core
+} pool = {
+    .run_lock = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .job_ready = PTHREAD_COND_INITIALIZER,
+    .job_done = PTHREAD_COND_INITIALIZER,
+    .threshold = BEAD_PARALLEL_DEFAULT_THRESHOLD
+};
+
+uint32_t get_bead_cpu_count(void) {
+#if defined(_SC_NPROCESSORS_ONLN)
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores > 0) return (uint32_t)cores;
+#endif
+    return 1;
+}
+
+void set_bead_parallel_threshold(uint32_t min_beads) {
+    pool.threshold = min_beads;
+}
+
+uint32_t get_bead_parallel_threshold(void) {
+    return pool.threshold;
+}
+
+void set_bead_parallel_threads(uint32_t num_threads) {
+    pool.num_threads = num_threads;
+}
+
+uint32_t get_bead_parallel_threads(void) {
+    uint32_t threads = pool.num_threads ? pool.num_threads : get_bead_cpu_count();
+    return threads < MAX_BEAD_PARALLEL_THREADS ? threads : MAX_BEAD_PARALLEL_THREADS;
+}
+
+bool use_bead_parallel(uint32_t count) {
+    return pool.threshold != UINT32_MAX && count >= pool.threshold && get_bead_parallel_threads() > 1;
+}
+
+// Claim and run tasks of the current job until none are left. Called with
+// pool.lock held; drops it while a task runs.
+static void run_pending_tasks(void) {
+    while (pool.next_task < pool.num_tasks) {
+        uint32_t index = pool.next_task++;
+        void (*task)(uint32_t, void*) = pool.task;
+        void* context = pool.context;
+        pthread_mutex_unlock(&pool.lock);
+        task(index, context);
+        pthread_mutex_lock(&pool.lock);
+        if (++pool.finished_tasks == pool.num_tasks) {
+            pthread_cond_broadcast(&pool.job_done);
+        }
+    }
+}
+
+static void* pool_worker(void* arg) {
+    (void)arg;
+    pthread_mutex_lock(&pool.lock);
+    while (!pool.stopping) {
+        if (pool.next_task < pool.num_tasks) {
+            run_pending_tasks();
+        } else {
+            pthread_cond_wait(&pool.job_ready, &pool.lock);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+// Join every worker. Called with run_lock held, so no job is in flight.
+static void stop_workers(void) {
+    pthread_mutex_lock(&pool.lock);
+    pool.stopping = true;
+    pthread_cond_broadcast(&pool.job_ready);
+    pthread_mutex_unlock(&pool.lock);
+    for (uint32_t i = 0; i < pool.num_workers; i++) {
+        pthread_join(pool.workers[i], NULL);
+    }
+    pool.num_workers = 0;
+    pool.stopping = false;
+}
+
+// Start or resize the pool so it has one worker per thread besides the caller
+static void ensure_workers(void) {
+    uint32_t wanted = get_bead_parallel_threads() - 1;
+    if (pool.num_workers == wanted) return;
+
+    stop_workers();
+    while (pool.num_workers < wanted &&
+           pthread_create(&pool.workers[pool.num_workers], NULL, pool_worker, NULL) == 0) {
+        pool.num_workers++;
+    }
+}
+
+void run_bead_parallel(uint32_t num_tasks, void (*task)(uint32_t index, void* context), void* context) {
+    if (num_tasks == 0) return;
+
+    pthread_mutex_lock(&pool.run_lock);
+    ensure_workers();
+    if (pool.num_workers == 0 || num_tasks == 1) {
+        for (uint32_t i = 0; i < num_tasks; i++) task(i, context);
+        pthread_mutex_unlock(&pool.run_lock);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.task = task;
+    pool.context = context;
+    pool.num_tasks = num_tasks;
+    pool.next_task = 0;
+    pool.finished_tasks = 0;
+    pthread_cond_broadcast(&pool.job_ready);
+    run_pending_tasks();
+    while (pool.finished_tasks < pool.num_tasks) {
+        pthread_cond_wait(&pool.job_done, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.run_lock);
+}
+
+void shutdown_bead_parallel(void) {
+    pthread_mutex_lock(&pool.run_lock);
+    stop_workers();
+    pthread_mutex_unlock(&pool.run_lock);
+}
@@ -0,0 +1,38 @@
+#ifndef BEAD_PARALLEL_H
+#define BEAD_PARALLEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Shared worker pool for catalog queries. Filter queries over collections of
+// at least the parallel threshold split the slots into partitions, evaluate
+// them on the pool and merge the results in slot order; smaller collections
+// stay on the calling thread, where a scan is cheaper than waking workers.
+#define BEAD_PARALLEL_DEFAULT_THRESHOLD (256u * 1024u)
+#define MAX_BEAD_PARALLEL_THREADS 64
+
+// Collections with at least min_beads beads are queried in parallel.
+// UINT32_MAX turns parallel queries off.
+void set_bead_parallel_threshold(uint32_t min_beads);
+uint32_t get_bead_parallel_threshold(void);
+
+// Threads used for parallel queries, including the caller; 0 means one per
+// core. Takes effect on the next parallel query.
+void set_bead_parallel_threads(uint32_t num_threads);
+uint32_t get_bead_parallel_threads(void);
+
+// Whether a query over count beads should run on the pool
+bool use_bead_parallel(uint32_t count);
+
+// Run task(index, context) for every index in [0, num_tasks) on the pool and
+// the calling thread, returning once all have finished. Calls from several
+// threads are serialized. Falls back to running inline if no worker starts.
+void run_bead_parallel(uint32_t num_tasks, void (*task)(uint32_t index, void* context), void* context);
+
+// Number of online CPU cores (at least 1)
+uint32_t get_bead_cpu_count(void);
+
+// Stop the pool's workers; the next parallel query starts them again
+void shutdown_bead_parallel(void);
+
+#endif // BEAD_PARALLEL_H
@@ -0,0 +1,555 @@
+// Trigram index and ranked text search over bead names, descriptions and categories
+#include "bead_search.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Query trigrams past this many are ignored
+#define MAX_QUERY_TRIGRAMS 64
+// Text is normalized into buffers of this size when verifying a match
+#define MAX_SEARCH_TEXT 1024
+// Candidates kept for exact re-ranking per requested result
+#define SEARCH_RERANK_FACTOR 4
+
+// Posting list of one trigram. Entries are slot << 1, plus 1 when the trigram
+// came from the name rather than the description or category. They are
+// ordered by slot and never repeat.
+typedef struct {
+    uint32_t* entries;
+    uint32_t count;
+    uint32_t capacity;
+    bool inherited;               // entries is shared with the index this one was forked from
+} TrigramPostings;
+
+struct BeadSearchIndex {
+    uint32_t* keys;               // Open-addressing table of trigrams (0 = empty)
+    uint32_t* lists;              // Posting list of each key, parallel to keys
+    uint32_t table_capacity;      // Always a power of two
+    TrigramPostings* postings;
+    uint32_t num_postings;
+    uint32_t postings_capacity;
+    uint32_t indexed_count;       // Slots [0, indexed_count) are in the index
+
+    // Inherited entry buffers a fork outgrew. Older indexes still read them,
+    // so they are freed with the newest index.
+    uint32_t** retired;
+    uint32_t num_retired;
+    uint32_t retired_capacity;
+    bool forked;                  // The entry buffers moved to a fork; free leaves them
+};
+
+typedef void (*TrigramVisitor)(uint32_t trigram, void* context);
+
+// Lowercase ASCII letters; anything that is not a letter, digit or UTF-8 byte
+// separates words
+static unsigned char fold_char(unsigned char c) {
+    if (c >= 'A' && c <= 'Z') return (unsigned char)(c - 'A' + 'a');
+    if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c >= 0x80) return c;
+    return ' ';
+}
+
+// Fold text into out as words separated by single spaces. Returns the length.
+static size_t normalize_text(const char* text, char* out, size_t capacity) {
+    size_t length = 0;
+    bool pending_space = false;
+    for (const unsigned char* p = (const unsigned char*)text; p && *p && length + 1 < capacity; p++) {
+        unsigned char c = fold_char(*p);
+        if (c == ' ') {
+            pending_space = length > 0;
+        } else {
+            if (pending_space && length + 2 < capacity) out[length++] = ' ';
+            pending_space = false;
+            out[length++] = (char)c;
+        }
+    }
+    out[length] = '\0';
+    return length;
+}
+
+// Visit the trigrams of every word in text, packed as three bytes. pad_start
+// adds the "  w" and " wo" trigrams that mark a word start, pad_end the "d "
+// trigram that marks its end, and join_words the "d w" trigram spanning each
+// pair of neighbouring words, so substring queries can check adjacency.
+static void for_each_trigram(const char* text, bool pad_start, bool pad_end, bool join_words,
+                             TrigramVisitor visit, void* context) {
+    const unsigned char* p = (const unsigned char*)text;
+    unsigned char previous_last = 0;
+    while (p && *p) {
+        while (*p && fold_char(*p) == ' ') p++;
+        if (!*p) break;
+
+        if (join_words && previous_last) {
+            visit((uint32_t)previous_last << 16 | (uint32_t)' ' << 8 | fold_char(*p), context);
+        }
+        uint32_t window = pad_start ? ((uint32_t)' ' << 8 | ' ') : 0;
+        uint32_t length = pad_start ? 2 : 0;
+        for (; *p && fold_char(*p) != ' '; p++) {
+            window = ((window << 8) | fold_char(*p)) & 0xFFFFFF;
+            if (++length >= 3) visit(window, context);
+        }
+        if (pad_end && length >= 2) {
+            visit(((window << 8) | ' ') & 0xFFFFFF, context);
+        }
+        previous_last = (unsigned char)(window & 0xFF);
+    }
+}
+
+static uint32_t trigram_hash(uint32_t trigram) {
+    uint32_t hash = trigram * 2654435761u;
+    return hash ^ (hash >> 15);
+}
+
+static uint32_t table_probe(const BeadSearchIndex* index, uint32_t trigram) {
+    uint32_t mask = index->table_capacity - 1;
+    uint32_t pos = trigram_hash(trigram) & mask;
+    while (index->keys[pos] != 0 && index->keys[pos] != trigram) {
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+static bool table_grow(BeadSearchIndex* index) {
+    uint32_t new_capacity = index->table_capacity ? index->table_capacity * 2 : 1024;
+    uint32_t* keys = calloc(new_capacity, sizeof(uint32_t));
+    uint32_t* lists = malloc(new_capacity * sizeof(uint32_t));
+    if (!keys || !lists) {
+        free(keys);
+        free(lists);
+        return false;
+    }
+
+    BeadSearchIndex resized = *index;
+    resized.keys = keys;
+    resized.lists = lists;
+    resized.table_capacity = new_capacity;
+    for (uint32_t i = 0; i < index->table_capacity; i++) {
+        if (index->keys[i]) {
+            uint32_t pos = table_probe(&resized, index->keys[i]);
+            keys[pos] = index->keys[i];
+            lists[pos] = index->lists[i];
+        }
+    }
+    free(index->keys);
+    free(index->lists);
+    *index = resized;
+    return true;
+}
+
+static TrigramPostings* find_postings(const BeadSearchIndex* index, uint32_t trigram) {
+    if (index->table_capacity == 0) return NULL;
+    uint32_t pos = table_probe(index, trigram);
+    return index->keys[pos] ? &index->postings[index->lists[pos]] : NULL;
+}
+
+static TrigramPostings* get_or_add_postings(BeadSearchIndex* index, uint32_t trigram) {
+    TrigramPostings* existing = find_postings(index, trigram);
+    if (existing) return existing;
+
+    // Keep the table at most half full so probe chains stay short
+    if ((index->num_postings + 1) * 2 > index->table_capacity && !table_grow(index)) {
+        return NULL;
+    }
+    if (index->num_postings >= index->postings_capacity) {
+        uint32_t new_capacity = index->postings_capacity ? index->postings_capacity * 2 : 512;
+        TrigramPostings* resized = realloc(index->postings, new_capacity * sizeof(TrigramPostings));
+        if (!resized) return NULL;
+        index->postings = resized;
+        index->postings_capacity = new_capacity;
+    }
+
+    uint32_t pos = table_probe(index, trigram);
+    index->keys[pos] = trigram;
+    index->lists[pos] = index->num_postings;
+    TrigramPostings* postings = &index->postings[index->num_postings++];
+    memset(postings, 0, sizeof(TrigramPostings));
+    return postings;
+}
+
+// Double a posting list's capacity. Older indexes read an inherited list up to
+// their own count, so it is copied rather than reallocated and the old buffer
+// is retired.
+static bool grow_postings(BeadSearchIndex* index, TrigramPostings* postings) {
+    uint32_t new_capacity = postings->capacity ? postings->capacity * 2 : 4;
+    if (!postings->inherited || !postings->entries) {
+        uint32_t* resized = realloc(postings->entries, new_capacity * sizeof(uint32_t));
+        if (!resized) return false;
+        postings->entries = resized;
+        postings->capacity = new_capacity;
+        postings->inherited = false;
+        return true;
+    }
+
+    if (index->num_retired >= index->retired_capacity) {
+        uint32_t retired_capacity = index->retired_capacity ? index->retired_capacity * 2 : 64;
+        uint32_t** resized = realloc(index->retired, retired_capacity * sizeof(uint32_t*));
+        if (!resized) return false;
+        index->retired = resized;
+        index->retired_capacity = retired_capacity;
+    }
+    uint32_t* copy = malloc(new_capacity * sizeof(uint32_t));
+    if (!copy) return false;
+    memcpy(copy, postings->entries, postings->count * sizeof(uint32_t));
+    index->retired[index->num_retired++] = postings->entries;
+    postings->entries = copy;
+    postings->capacity = new_capacity;
+    postings->inherited = false;
+    return true;
+}
+
+typedef struct {
+    BeadSearchIndex* index;
+    uint32_t entry;
+    bool ok;
+} IndexVisit;
+
+static void index_trigram(uint32_t trigram, void* context) {
+    IndexVisit* visit = context;
+    TrigramPostings* postings = get_or_add_postings(visit->index, trigram);
+    if (!postings) {
+        visit->ok = false;
+        return;
+    }
+    // A slot's trigrams arrive together, so a repeat is always the last entry
+    if (postings->count && postings->entries[postings->count - 1] == visit->entry) return;
+
+    if (postings->count >= postings->capacity && !grow_postings(visit->index, postings)) {
+        visit->ok = false;
+        return;
+    }
+    postings->entries[postings->count++] = visit->entry;
+}
+
+static bool index_bead(BeadSearchIndex* index, uint32_t slot, const BeadDefinition* bead) {
+    IndexVisit visit = { index, slot << 1 | 1, true };
+    for_each_trigram(bead->name, true, true, true, index_trigram, &visit);
+    visit.entry = slot << 1;
+    for_each_trigram(bead->description, true, true, true, index_trigram, &visit);
+    for_each_trigram(bead->category, true, true, true, index_trigram, &visit);
+    return visit.ok;
+}
+
+bool update_bead_search_index(BeadCollection* collection) {
+    if (!collection) return false;
+    // Up to date, as published catalog versions are: readers write nothing
+    BeadSearchIndex* current = collection->search_index;
+    if (current && current->indexed_count >= collection->count) return true;
+    // A forked index's posting lists grow on behalf of the fork
+    if (current && current->forked) return false;
+    if (!current) {
+        collection->search_index = calloc(1, sizeof(BeadSearchIndex));
+        if (!collection->search_index) return false;
+    }
+
+    // Slots are shifted left by one in the posting entries
+    BeadSearchIndex* index = collection->search_index;
+    while (index->indexed_count < collection->count && index->indexed_count < (UINT32_MAX >> 1)) {
+        if (!index_bead(index, index->indexed_count, get_bead_at(collection, index->indexed_count))) {
+            return false;
+        }
+        index->indexed_count++;
+    }
+    return true;
+}
+
+BeadSearchIndex* fork_bead_search_index(BeadSearchIndex* index) {
+    if (!index || index->forked) return NULL;
+
+    BeadSearchIndex* fork = malloc(sizeof(BeadSearchIndex));
+    if (!fork) return NULL;
+    *fork = *index;
+    fork->keys = NULL;
+    fork->lists = NULL;
+    fork->postings = NULL;
+    // An index that has seen no trigrams yet has no table to copy
+    if (index->table_capacity > 0) {
+        fork->keys = malloc(index->table_capacity * sizeof(uint32_t));
+        fork->lists = malloc(index->table_capacity * sizeof(uint32_t));
+        fork->postings = malloc((index->postings_capacity ? index->postings_capacity : 1) * sizeof(TrigramPostings));
+        if (!fork->keys || !fork->lists || !fork->postings) {
+            free(fork->keys);
+            free(fork->lists);
+            free(fork->postings);
+            free(fork);
+            return NULL;
+        }
+        memcpy(fork->keys, index->keys, index->table_capacity * sizeof(uint32_t));
+        memcpy(fork->lists, index->lists, index->table_capacity * sizeof(uint32_t));
+        if (index->num_postings > 0) {
+            memcpy(fork->postings, index->postings, index->num_postings * sizeof(TrigramPostings));
+        }
+    }
+    for (uint32_t i = 0; i < fork->num_postings; i++) fork->postings[i].inherited = true;
+    index->forked = true;
+    return fork;
+}
+
+void unfork_bead_search_index(BeadSearchIndex* fork, BeadSearchIndex* index) {
+    if (!fork || !index) return;
+
+    // Lists the fork copied or started are its own; retired buffers it added
+    // are still in use by index
+    for (uint32_t i = 0; i < fork->num_postings; i++) {
+        if (!fork->postings[i].inherited) free(fork->postings[i].entries);
+    }
+    index->retired = fork->retired;
+    index->retired_capacity = fork->retired_capacity;
+    index->forked = false;
+    free(fork->postings);
+    free(fork->keys);
+    free(fork->lists);
+    free(fork);
+}
+
+void free_bead_search_index(BeadSearchIndex* index) {
+    if (index) {
+        if (!index->forked) {
+            for (uint32_t i = 0; i < index->num_postings; i++) free(index->postings[i].entries);
+            for (uint32_t i = 0; i < index->num_retired; i++) free(index->retired[i]);
+            free(index->retired);
+        }
+        free(index->postings);
+        free(index->keys);
+        free(index->lists);
+        free(index);
+    }
+}
+
+typedef struct {
+    uint32_t trigrams[MAX_QUERY_TRIGRAMS];
+    uint32_t count;
+} QueryTrigrams;
+
+static void collect_query_trigram(uint32_t trigram, void* context) {
+    QueryTrigrams* query = context;
+    for (uint32_t i = 0; i < query->count; i++) {
+        if (query->trigrams[i] == trigram) return;
+    }
+    if (query->count < MAX_QUERY_TRIGRAMS) query->trigrams[query->count++] = trigram;
+}
+
+typedef struct {
+    uint32_t slot;
+    float score;
+} SearchCandidate;
+
+static bool candidate_better(SearchCandidate a, SearchCandidate b) {
+    return a.score > b.score || (a.score == b.score && a.slot < b.slot);
+}
+
+// Bounded min-heap keeping the best candidates seen; the worst sits at the root
+typedef struct {
+    SearchCandidate* items;
+    uint32_t count;
+    uint32_t capacity;
+} CandidateHeap;
+
+static void heap_offer(CandidateHeap* heap, SearchCandidate candidate) {
+    uint32_t i;
+    if (heap->count < heap->capacity) {
+        i = heap->count++;
+        while (i > 0 && candidate_better(heap->items[(i - 1) / 2], candidate)) {
+            heap->items[i] = heap->items[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        heap->items[i] = candidate;
+        return;
+    }
+    if (heap->capacity == 0 || !candidate_better(candidate, heap->items[0])) return;
+
+    // Replace the root and sift the new candidate down
+    i = 0;
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && candidate_better(heap->items[child], heap->items[child + 1])) child++;
+        if (!candidate_better(candidate, heap->items[child])) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    heap->items[i] = candidate;
+}
+
+static int compare_candidates(const void* a, const void* b) {
+    SearchCandidate x = *(const SearchCandidate*)a;
+    SearchCandidate y = *(const SearchCandidate*)b;
+    return candidate_better(x, y) ? -1 : (candidate_better(y, x) ? 1 : 0);
+}
+
+// True when every word of the normalized query starts a word of the normalized text
+static bool words_start_words(const char* query, const char* text) {
+    while (*query) {
+        size_t length = strcspn(query, " ");
+        bool found = false;
+        for (const char* word = text; *word && !found; ) {
+            found = strncmp(word, query, length) == 0;
+            word += strcspn(word, " ");
+            while (*word == ' ') word++;
+        }
+        if (!found) return false;
+        query += length;
+        while (*query == ' ') query++;
+    }
+    return true;
+}
+
+static bool text_matches(const char* query, const char* text, BeadSearchMode mode) {
+    return mode == BEAD_SEARCH_PREFIX ? words_start_words(query, text) : strstr(text, query) != NULL;
+}
+
+// Exact score of a candidate, or a negative value if it does not really match.
+// Name matches score 2, a name that starts with the query 3, other fields 1;
+// fuzzy candidates add these bonuses to their trigram score. Shorter names
+// win ties. Only fields holding all needed trigrams are checked.
+static float score_candidate(BeadCollection* collection, uint32_t slot, const char* query, BeadSearchMode mode,
+                             float trigram_score, uint16_t hits, uint32_t needed) {
+    BeadDefinition* bead = get_bead_at(collection, slot);
+    char text[MAX_SEARCH_TEXT];
+    size_t name_length = normalize_text(bead->name, text, sizeof(text));
+    float score;
+
+    if (mode == BEAD_SEARCH_FUZZY) {
+        score = trigram_score;
+        const char* found = strstr(text, query);
+        if (found) score += found == text ? 1.5f : 1.0f;
+    } else if ((hits >> 8) == needed && text_matches(query, text, mode)) {
+        score = strncmp(text, query, strlen(query)) == 0 ? 3.0f : 2.0f;
+    } else {
+        if ((hits & 0xFF) != needed) return -1.0f;
+        normalize_text(bead->description, text, sizeof(text));
+        if (!text_matches(query, text, mode)) {
+            normalize_text(bead->category, text, sizeof(text));
+            if (!text_matches(query, text, mode)) return -1.0f;
+        }
+        score = 1.0f;
+    }
+    return score - 0.001f * (float)(name_length < 255 ? name_length : 255);
+}
+
+// Order the heap best first and copy it out
+static uint32_t emit_results(BeadCollection* collection, CandidateHeap* heap,
+                             BeadSearchResult* out, uint32_t max_results) {
+    qsort(heap->items, heap->count, sizeof(SearchCandidate), compare_candidates);
+    uint32_t written = heap->count < max_results ? heap->count : max_results;
+    for (uint32_t i = 0; i < written; i++) {
+        out[i].bead = get_bead_at(collection, heap->items[i].slot);
+        out[i].score = heap->items[i].score;
+    }
+    return written;
+}
+
+static void collect_substring_trigrams(const char* needle, size_t length, QueryTrigrams* query) {
+    for (size_t i = 0; i + 3 <= length; i++) {
+        const unsigned char* p = (const unsigned char*)needle + i;
+        collect_query_trigram((uint32_t)p[0] << 16 | (uint32_t)p[1] << 8 | p[2], query);
+    }
+}
+
+uint32_t search_beads(BeadCollection* collection, const char* query, BeadSearchMode mode,
+                      BeadSearchResult* out, uint32_t max_results) {
+    if (!collection || !query || !out || max_results == 0) return 0;
+    if (!update_bead_search_index(collection)) return 0;
+
+    char needle[MAX_SEARCH_TEXT];
+    size_t length = normalize_text(query, needle, sizeof(needle));
+    if (length == 0) return 0;
+
+    // Too short for a trigram, a substring query matches word prefixes instead
+    if (mode == BEAD_SEARCH_SUBSTRING && length < 3) mode = BEAD_SEARCH_PREFIX;
+
+    // Substring queries may start and end mid-word; prefix queries leave each
+    // word open at the end; fuzzy queries match words in any order
+    QueryTrigrams trigrams = {0};
+    if (mode == BEAD_SEARCH_SUBSTRING) {
+        collect_substring_trigrams(needle, length, &trigrams);
+    } else {
+        for_each_trigram(needle, true, mode == BEAD_SEARCH_FUZZY, false, collect_query_trigram, &trigrams);
+    }
+    if (trigrams.count == 0) return 0;
+
+    BeadSearchIndex* index = collection->search_index;
+    const TrigramPostings* lists[MAX_QUERY_TRIGRAMS];
+    uint32_t num_lists = 0;
+    for (uint32_t i = 0; i < trigrams.count; i++) {
+        const TrigramPostings* postings = find_postings(index, trigrams.trigrams[i]);
+        if (postings) {
+            lists[num_lists++] = postings;
+        } else if (mode != BEAD_SEARCH_FUZZY) {
+            return 0;  // No bead has every trigram
+        }
+    }
+    if (num_lists == 0) return 0;
+
+    // Count trigram hits per slot, name hits in the high byte and others in the low
+    uint32_t count = index->indexed_count;
+    uint16_t* hits = calloc(count, sizeof(uint16_t));
+    uint32_t* touched = malloc(count * sizeof(uint32_t));
+    uint32_t heap_capacity = max_results <= UINT32_MAX / SEARCH_RERANK_FACTOR ? max_results * SEARCH_RERANK_FACTOR : UINT32_MAX;
+    if (heap_capacity > count) heap_capacity = count;
+    CandidateHeap heap = { malloc((heap_capacity ? heap_capacity : 1) * sizeof(SearchCandidate)), 0, heap_capacity };
+    if (!hits || !touched || !heap.items) {
+        free(hits);
+        free(touched);
+        free(heap.items);
+        return 0;
+    }
+
+    uint32_t num_touched = 0;
+    for (uint32_t i = 0; i < num_lists; i++) {
+        const uint32_t* entries = lists[i]->entries;
+        for (uint32_t j = 0; j < lists[i]->count; j++) {
+            uint32_t slot = entries[j] >> 1;
+            if (hits[slot] == 0) touched[num_touched++] = slot;
+            hits[slot] += (entries[j] & 1) ? 0x100 : 1;
+        }
+    }
+
+    // Keep the best candidates by trigram score, then verify and re-rank them
+    float total = (float)trigrams.count;
+    uint32_t candidates = 0;
+    for (uint32_t i = 0; i < num_touched; i++) {
+        uint32_t slot = touched[i];
+        uint32_t name_hits = hits[slot] >> 8;
+        uint32_t other_hits = hits[slot] & 0xFF;
+        float score;
+        if (mode == BEAD_SEARCH_FUZZY) {
+            float name_score = (float)name_hits / total;
+            float other_score = 0.8f * (float)other_hits / total;
+            score = name_score > other_score ? name_score : other_score;
+            if (score < BEAD_SEARCH_FUZZY_THRESHOLD) continue;
+        } else if (name_hits == trigrams.count) {
+            score = 2.0f;
+        } else if (other_hits == trigrams.count) {
+            score = 1.0f;
+        } else {
+            continue;
+        }
+        candidates++;
+        heap_offer(&heap, (SearchCandidate){ slot, score });
+    }
+
+    uint32_t verified = 0;
+    for (uint32_t i = 0; i < heap.count; i++) {
+        uint32_t slot = heap.items[i].slot;
+        float score = score_candidate(collection, slot, needle, mode, heap.items[i].score, hits[slot], trigrams.count);
+        if (score >= 0.0f) heap.items[verified++] = (SearchCandidate){ slot, score };
+    }
+
+    // Trigram false positives crowded out real matches: verify every candidate
+    if (verified < max_results && verified < heap.count && candidates > heap.count) {
+        heap.count = 0;
+        for (uint32_t i = 0; i < num_touched; i++) {
+            uint32_t slot = touched[i];
+            bool all_hits = (hits[slot] >> 8) == trigrams.count || (hits[slot] & 0xFF) == trigrams.count;
+            if (!all_hits) continue;
+            float score = score_candidate(collection, slot, needle, mode, 0.0f, hits[slot], trigrams.count);
+            if (score >= 0.0f) heap_offer(&heap, (SearchCandidate){ slot, score });
+        }
+        verified = heap.count;
+    }
+    heap.count = verified;
+
+    uint32_t written = emit_results(collection, &heap, out, max_results);
+    free(hits);
+    free(touched);
+    free(heap.items);
+    return written;
+}
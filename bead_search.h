@@ -0,0 +1,45 @@
+#ifndef BEAD_SEARCH_H
+#define BEAD_SEARCH_H
+
+#include "bead.h"
+
+// How search_beads matches the query against a bead's name, description and
+// category. Matching is case-insensitive and treats punctuation as spaces.
+typedef enum {
+    BEAD_SEARCH_PREFIX,     // Every query word starts a word of one field ("cry rou")
+    BEAD_SEARCH_SUBSTRING,  // The query appears anywhere in one field ("stal")
+    BEAD_SEARCH_FUZZY       // Shares most trigrams with the text, tolerating typos ("crystl")
+} BeadSearchMode;
+
+typedef struct {
+    BeadDefinition* bead;
+    float score;            // Higher is better; name matches outrank description matches
+} BeadSearchResult;
+
+// Fuzzy matches need at least this fraction of the query's trigrams
+#define BEAD_SEARCH_FUZZY_THRESHOLD 0.5f
+
+// Write the best max_results matches into out, best first, and return how many
+// were written. The trigram index is built on the first search and extended
+// with any beads added since on later ones.
+uint32_t search_beads(BeadCollection* collection, const char* query, BeadSearchMode mode,
+                      BeadSearchResult* out, uint32_t max_results);
+
+// Bring the collection's search index up to date without searching
+bool update_bead_search_index(BeadCollection* collection);
+
+// Start the search index of the next version (called by clone_bead_collection).
+// The fork copies the trigram table but shares the posting lists: it appends
+// past their ends in place and copies a list only when it must grow, so older
+// versions keep reading their own prefix. index stays readable but is not
+// updated again, and freeing it leaves the shared lists to the fork.
+BeadSearchIndex* fork_bead_search_index(BeadSearchIndex* index);
+
+// Undo fork_bead_search_index: free the fork and what it added, and give the
+// shared lists back to index
+void unfork_bead_search_index(BeadSearchIndex* fork, BeadSearchIndex* index);
+
+// Release a search index (called by free_bead_collection)
+void free_bead_search_index(BeadSearchIndex* index);
+
+#endif // BEAD_SEARCH_H
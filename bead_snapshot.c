@@ -0,0 +1,138 @@
+// Versioned catalog snapshots: lock-free pinning, deferred reclamation
+#include "bead_snapshot.h"
+#include "bead_search.h"
+#include "bead_color_index.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+
+typedef struct RetiredVersion {
+    BeadCollection* collection;
+    struct RetiredVersion* next;
+} RetiredVersion;
+
+struct BeadCatalog {
+    BeadCollection* current;      // Swapped atomically by publish
+    uint32_t acquiring;           // Readers between loading current and pinning it
+    uint64_t version;
+    pthread_mutex_t writer_lock;  // Held from begin_bead_catalog_update to publish or discard
+    pthread_mutex_t retired_lock;
+    RetiredVersion* retired;      // Replaced versions not yet freed
+};
+
+// Merge the size index and bring the search and color indexes up to date, so
+// readers of the version find nothing left to build and never write to it.
+// The indexes of a clone are forks, so only the beads it added are indexed.
+static void complete_bead_indexes(BeadCollection* collection) {
+    get_bead_size_iterator(collection, 0.0f, 0.0f);
+    update_bead_search_index(collection);
+    update_bead_color_index(collection);
+}
+
+BeadCatalog* create_bead_catalog(BeadCollection* collection) {
+    if (!collection || collection->frozen) return NULL;
+    BeadCatalog* catalog = calloc(1, sizeof(BeadCatalog));
+    if (!catalog) return NULL;
+
+    complete_bead_indexes(collection);
+    catalog->current = collection;
+    pthread_mutex_init(&catalog->writer_lock, NULL);
+    pthread_mutex_init(&catalog->retired_lock, NULL);
+    return catalog;
+}
+
+BeadCollection* acquire_bead_snapshot(BeadCatalog* catalog) {
+    if (!catalog) return NULL;
+    // Announcing the acquire first keeps reclaim from freeing the version
+    // between the load and the pin
+    __atomic_add_fetch(&catalog->acquiring, 1, __ATOMIC_SEQ_CST);
+    BeadCollection* snapshot = __atomic_load_n(&catalog->current, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&snapshot->snapshot_readers, 1, __ATOMIC_SEQ_CST);
+    __atomic_sub_fetch(&catalog->acquiring, 1, __ATOMIC_SEQ_CST);
+    return snapshot;
+}
+
+void release_bead_snapshot(BeadCatalog* catalog, BeadCollection* snapshot) {
+    (void)catalog;
+    if (snapshot) __atomic_sub_fetch(&snapshot->snapshot_readers, 1, __ATOMIC_SEQ_CST);
+}
+
+BeadCollection* begin_bead_catalog_update(BeadCatalog* catalog) {
+    if (!catalog) return NULL;
+    pthread_mutex_lock(&catalog->writer_lock);
+    BeadCollection* next = clone_bead_collection(catalog->current);
+    if (!next) pthread_mutex_unlock(&catalog->writer_lock);
+    return next;
+}
+
+void publish_bead_catalog_update(BeadCatalog* catalog, BeadCollection* next) {
+    if (!catalog || !next) return;
+    BeadCollection* previous = catalog->current;
+
+    complete_bead_indexes(next);
+
+    RetiredVersion* retired = malloc(sizeof(RetiredVersion));
+    __atomic_store_n(&catalog->current, next, __ATOMIC_SEQ_CST);
+    catalog->version++;
+    pthread_mutex_unlock(&catalog->writer_lock);
+
+    // Without a list node the old version leaks rather than risk freeing it
+    // under a reader
+    if (retired) {
+        pthread_mutex_lock(&catalog->retired_lock);
+        retired->collection = previous;
+        retired->next = catalog->retired;
+        catalog->retired = retired;
+        pthread_mutex_unlock(&catalog->retired_lock);
+    }
+    reclaim_bead_snapshots(catalog);
+}
+
+void discard_bead_catalog_update(BeadCatalog* catalog, BeadCollection* next) {
+    if (!catalog || !next) return;
+    discard_bead_collection_clone(next, catalog->current);
+    pthread_mutex_unlock(&catalog->writer_lock);
+}
+
+uint64_t get_bead_catalog_version(BeadCatalog* catalog) {
+    return catalog ? catalog->version : 0;
+}
+
+void reclaim_bead_snapshots(BeadCatalog* catalog) {
+    if (!catalog) return;
+    pthread_mutex_lock(&catalog->retired_lock);
+
+    // A reader that loaded a replaced version before the swap pins it before
+    // leaving the acquiring window, so once the window is empty the pin
+    // counts of replaced versions can only go down
+    while (__atomic_load_n(&catalog->acquiring, __ATOMIC_SEQ_CST) != 0) {
+        sched_yield();
+    }
+
+    RetiredVersion** link = &catalog->retired;
+    while (*link) {
+        RetiredVersion* retired = *link;
+        if (__atomic_load_n(&retired->collection->snapshot_readers, __ATOMIC_SEQ_CST) == 0) {
+            *link = retired->next;
+            free_bead_collection(retired->collection);
+            free(retired);
+        } else {
+            link = &retired->next;
+        }
+    }
+    pthread_mutex_unlock(&catalog->retired_lock);
+}
+
+void free_bead_catalog(BeadCatalog* catalog) {
+    if (!catalog) return;
+    while (catalog->retired) {
+        RetiredVersion* retired = catalog->retired;
+        catalog->retired = retired->next;
+        free_bead_collection(retired->collection);
+        free(retired);
+    }
+    free_bead_collection(catalog->current);
+    pthread_mutex_destroy(&catalog->writer_lock);
+    pthread_mutex_destroy(&catalog->retired_lock);
+    free(catalog);
+}
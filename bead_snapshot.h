@@ -0,0 +1,54 @@
+#ifndef BEAD_SNAPSHOT_H
+#define BEAD_SNAPSHOT_H
+
+#include "bead.h"
+
+// Versioned bead catalog for concurrent readers and writers, in the style of
+// RCU. Readers pin the current version without locking or waiting and see it
+// unchanged until they release it. A writer clones the current version (see
+// clone_bead_collection), adds to the clone and publishes it as the next
+// version. Replaced versions are freed once no reader holds them.
+//
+// Versions share their definitions and strings, so BeadDefinition pointers
+// and the id, name and category strings of any version stay valid for as long
+// as the catalog exists. The search and color indexes share their posting
+// lists and grid cells; the other indexes are copied per version.
+//
+// Published versions are read-only: every index is complete before a version
+// can be pinned, so any number of threads may query one at once. Filter
+// results are cached per reader, in a BeadQueryCache each thread owns.
+typedef struct BeadCatalog BeadCatalog;
+
+// Create a catalog whose first version is collection, which it takes over.
+// The collection's indexes are built here, before any reader can pin it.
+BeadCatalog* create_bead_catalog(BeadCollection* collection);
+
+// Pin the current version for reading. Never blocks.
+BeadCollection* acquire_bead_snapshot(BeadCatalog* catalog);
+
+// Unpin a version returned by acquire_bead_snapshot
+void release_bead_snapshot(BeadCatalog* catalog, BeadCollection* snapshot);
+
+// Start the next version: returns a writable clone of the current one, or
+// NULL if it cannot be allocated. Writers take turns; this waits until any
+// other update has been published or discarded.
+BeadCollection* begin_bead_catalog_update(BeadCatalog* catalog);
+
+// Make an update the current version. Its size, search and color indexes are
+// completed first, indexing only the beads the update added.
+void publish_bead_catalog_update(BeadCatalog* catalog, BeadCollection* next);
+
+// Abandon an update; the current version is unchanged
+void discard_bead_catalog_update(BeadCatalog* catalog, BeadCollection* next);
+
+// Number of versions published so far, starting at 0 for the first
+uint64_t get_bead_catalog_version(BeadCatalog* catalog);
+
+// Free replaced versions that no reader holds. Publishing does this too;
+// call it to reclaim versions released since.
+void reclaim_bead_snapshots(BeadCatalog* catalog);
+
+// Free the catalog and every version. No reader may hold a version.
+void free_bead_catalog(BeadCatalog* catalog);
+
+#endif // BEAD_SNAPSHOT_H
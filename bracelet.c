@@ -4,212 +4,478 @@
 #include "clay.h"
 #include "bead_image.h"
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>  // Add this for memcpy and memmove
 #include "circle_menu.h"
 #include "bead.h"
+#include "bead_parallel.h"
 // External declarations
 extern BeadImage bead_images[];
 extern int num_bead_images;
 
-// Initialize the bracelet state
-BraceletState bracelet_state = {
-    .radius_px = 0.0f,
-    .bead_radius_px = 0.0f,
-    .num_slots = 0,
-    .beads = NULL,
-    .hovered_index = -1,
-    .selected_circle_index = -1,  // Initialize to no selection
-    .config = {
-        .bead_size_mm = 8.0f,         // Default 8mm beads
-        .bead_count = 24,             // Default 24 beads
-        .bracelet_diameter_mm = 60.0f  // Default ~60mm diameter
-    }
-};
-
-static void update_bead_positions(void) {
-    for (uint32_t i = 0; i < bracelet_state.num_slots; i++) {
-        float angle = (float)i / bracelet_state.num_slots * (2.0f * M_PI);
-        bracelet_state.beads[i].position = (Clay_Vector2){
-            .x = cosf(angle) * bracelet_state.radius_px,
-            .y = sinf(angle) * bracelet_state.radius_px
+// Fraction of the base circle's radius at which the slots sit
+#define SLOT_RING_SCALE 0.8f
+
+// Note that slots [first, last] hold different beads and may change size
+static void mark_slots_resized(BraceletDoc* doc, uint32_t first, uint32_t last) {
+    BraceletLayout* layout = &doc->layout;
+    if (first < layout->dirty_from) layout->dirty_from = first;
+    if (last > layout->dirty_to) layout->dirty_to = last;
+}
+
+static bool reserve_bracelet_layout(BraceletLayout* layout, uint32_t num_slots) {
+    if (layout->size_mm && num_slots <= layout->capacity) return true;
+    float* size_mm = realloc(layout->size_mm, (num_slots + 1) * sizeof(float));
+    if (!size_mm) return false;
+    layout->size_mm = size_mm;
+    float* start_mm = realloc(layout->start_mm, (num_slots + 1) * sizeof(float));
+    if (!start_mm) return false;
+    layout->start_mm = start_mm;
+    layout->capacity = num_slots;
+    return true;
+}
+
+void update_bracelet_layout(BraceletDoc* doc, BeadCollection* beads) {
+    BraceletLayout* layout = &doc->layout;
+    uint32_t num_slots = doc->num_slots;
+    uint32_t generation = beads ? beads->catalog_generation : 0;
+    float default_size = doc->config.bead_size_mm > 0.0f ? doc->config.bead_size_mm : 1.0f;
+
+    // Anything that can change every slot's size starts over from slot 0
+    bool full = !layout->valid || layout->num_slots != num_slots ||
+                layout->catalog_generation != generation || layout->default_size_mm != default_size;
+    if (full) {
+        if (!reserve_bracelet_layout(layout, num_slots)) {
+            layout->valid = false;
+            return;
+        }
+        layout->num_slots = num_slots;
+        layout->catalog_generation = generation;
+        layout->default_size_mm = default_size;
+        layout->max_size_mm = 0.0f;
+        layout->start_mm[0] = 0.0f;
+        layout->dirty_from = 0;
+        layout->dirty_to = num_slots;
+        layout->moved_from = 0;
+        layout->valid = true;
+    }
+
+    // Slots after the edited range only shift, and stop shifting once one
+    // ends where it did before
+    bool rescan_max = false;
+    uint32_t first_moved = num_slots;
+    for (uint32_t i = layout->dirty_from; i < num_slots; i++) {
+        const BeadDefinition* bead = get_bead_by_handle(beads, doc->beads[i].bead);
+        float size = bead && bead->size_mm > 0.0f ? bead->size_mm : default_size;
+        float end = layout->start_mm[i] + size;
+        if (!full && i > layout->dirty_to && end == layout->start_mm[i + 1]) break;
+
+        if (full || size != layout->size_mm[i]) {
+            if (!full && layout->size_mm[i] == layout->max_size_mm && size < layout->max_size_mm) {
+                rescan_max = true;
+            }
+            if (i < first_moved) first_moved = i;
+            layout->size_mm[i] = size;
+            if (size > layout->max_size_mm) layout->max_size_mm = size;
+        }
+        layout->start_mm[i + 1] = end;
+    }
+    layout->dirty_from = UINT32_MAX;
+    layout->dirty_to = 0;
+    if (rescan_max) {
+        layout->max_size_mm = 0.0f;
+        for (uint32_t i = 0; i < num_slots; i++) {
+            if (layout->size_mm[i] > layout->max_size_mm) layout->max_size_mm = layout->size_mm[i];
+        }
+    }
+
+    float length = layout->start_mm[num_slots];
+    float circumference = doc->config.bracelet_diameter_mm * (float)M_PI;
+    float span = length > circumference ? length : circumference;
+    // A new span rescales every angle
+    if (span != layout->span_mm) first_moved = 0;
+    layout->span_mm = span;
+    if (first_moved < layout->moved_from) layout->moved_from = first_moved;
+
+    float tolerance = default_size * 0.5f;
+    float gap = circumference - length;
+    layout->fit = (BraceletFit){
+        .status = gap > tolerance ? BRACELET_FIT_UNDERFILL :
+                  gap < -tolerance ? BRACELET_FIT_OVERFILL : BRACELET_FIT_OK,
+        .length_mm = length,
+        .circumference_mm = circumference,
+        .gap_mm = gap
+    };
+}
+
+BraceletFit get_bracelet_fit(BraceletDoc* doc) {
+    if (!doc->layout.valid) update_bracelet_layout(doc, NULL);
+    return doc->layout.fit;
+}
+
+static void free_bracelet_layout(BraceletLayout* layout) {
+    free(layout->size_mm);
+    free(layout->start_mm);
+    *layout = (BraceletLayout){0};
+}
+
+const BraceletGeometry* get_bracelet_geometry(BraceletDoc* doc) {
+    BraceletGeometry* geometry = &doc->geometry;
+    BraceletLayout* layout = &doc->layout;
+    if (!layout->valid || layout->num_slots != doc->num_slots) {
+        update_bracelet_layout(doc, NULL);
+        if (!layout->valid) {
+            geometry->valid = false;
+            geometry->num_slots = 0;
+            return geometry;
+        }
+    }
+
+    int screen_width = GetScreenWidth();
+    int screen_height = GetScreenHeight();
+    float ring_radius = doc->radius_px * SLOT_RING_SCALE;
+    bool slots_changed = !geometry->valid || geometry->num_slots != doc->num_slots;
+    bool view_changed = slots_changed || geometry->screen_width != screen_width ||
+                        geometry->screen_height != screen_height || geometry->ring_radius_px != ring_radius;
+    if (!view_changed && layout->moved_from >= layout->num_slots) {
+        return geometry;
+    }
+
+    if (slots_changed) {
+        if (doc->num_slots > geometry->capacity) {
+            BraceletSlotGeometry* slots = realloc(geometry->slots,
+                                                  doc->num_slots * sizeof(BraceletSlotGeometry));
+            if (!slots) {
+                geometry->valid = false;
+                geometry->num_slots = 0;
+                return geometry;
+            }
+            geometry->slots = slots;
+            geometry->capacity = doc->num_slots;
+        }
+        geometry->num_slots = doc->num_slots;
+        layout->moved_from = 0;
+    }
+
+    // Each slot sits at the middle of its stretch of cord, with slot 0 at
+    // angle 0. Only slots the layout moved need new angles.
+    float span = layout->span_mm > 0.0f ? layout->span_mm : 1.0f;
+    float first_center = geometry->num_slots > 0 ? layout->size_mm[0] * 0.5f : 0.0f;
+    for (uint32_t i = layout->moved_from; i < geometry->num_slots; i++) {
+        float center_mm = layout->start_mm[i] + layout->size_mm[i] * 0.5f - first_center;
+        float angle = center_mm / span * (2.0f * M_PI);
+        geometry->slots[i].angle = angle;
+        geometry->slots[i].direction = (Clay_Vector2){ cosf(angle), sinf(angle) };
+    }
+
+    geometry->center = (Clay_Vector2){ screen_width / 2, screen_height / 2 };
+    geometry->ring_radius_px = ring_radius;
+    geometry->screen_width = screen_width;
+    geometry->screen_height = screen_height;
+    geometry->valid = true;
+    float px_per_mm = 2.0f * M_PI * ring_radius / span;
+    geometry->max_radius_px = layout->max_size_mm * 0.5f * px_per_mm;
+    for (uint32_t i = view_changed ? 0 : layout->moved_from; i < geometry->num_slots; i++) {
+        Clay_Vector2 direction = geometry->slots[i].direction;
+        geometry->slots[i].center = (Clay_Vector2){
+            .x = geometry->center.x + direction.x * ring_radius,
+            .y = geometry->center.y + direction.y * ring_radius
         };
+        geometry->slots[i].radius_px = layout->size_mm[i] * 0.5f * px_per_mm;
     }
+    layout->moved_from = UINT32_MAX;
+    return geometry;
 }
 
-void initialize_bracelet(Clay_Arena* arena, BraceletConfig config) {
-    bracelet_state.config = config;
-    bracelet_state.num_slots = config.bead_count;
-    bracelet_state.radius_px = 150.0f;
-    bracelet_state.bead_radius_px = 15.0f;
-    bracelet_state.hovered_index = -1;
-    bracelet_state.circle_menu_visible = false;
-    
-    // Calculate center coordinates
-    float center_x = GetScreenWidth() / 2;
-    float center_y = GetScreenHeight() / 2;
+BraceletDoc* create_bracelet_doc(BraceletConfig config) {
+    BraceletDoc* doc = calloc(1, sizeof(BraceletDoc));
+    if (!doc) return NULL;
+    doc->selected_circle_index = -1;  // No selection
+    doc->undo.budget_bytes = BRACELET_UNDO_DEFAULT_BUDGET;
+    doc->config = config;
+    doc->num_slots = config.bead_count;
+    doc->radius_px = 150.0f;
+    doc->bead_radius_px = 15.0f;
+    doc->hovered_index = -1;
+    doc->circle_menu_visible = false;
     
     // Allocate memory for beads
     size_t beads_size = config.bead_count * sizeof(BraceletBead);
-    bracelet_state.beads = malloc(beads_size);
-    if (!bracelet_state.beads) {
+    doc->beads = malloc(beads_size);
+    doc->menu = circle_menu_create();
+    if ((!doc->beads && beads_size > 0) || !doc->menu) {
         fprintf(stderr, "Failed to allocate memory for beads\n");
-        return;
+        free_bracelet_doc(doc);
+        return NULL;
     }
     
-    // Initialize all slots as empty with white color
-    for (uint32_t i = 0; i < bracelet_state.num_slots; i++) {
-        bracelet_state.beads[i] = (BraceletBead){
-            .position = {0},
-            .color = {.r = 1.0f, .g = 1.0f, .b = 1.0f, .a = 1.0f},
-            .image_id = 0,
-            .bead_id = NULL
-        };
+    // Initialize all slots as empty
+    for (uint32_t i = 0; i < doc->num_slots; i++) {
+        doc->beads[i] = (BraceletBead){ .bead = {0} };
     }
     
-    // Initialize circle menu
-    bracelet_state.menu = circle_menu_create();
-    
-    // Add circles to menu
-    for (uint32_t i = 0; i < bracelet_state.num_slots; i++) {
-        float angle = (float)i / bracelet_state.num_slots * (2.0f * M_PI);
-        float x = center_x + cosf(angle) * (bracelet_state.radius_px * 0.8f);
-        float y = center_y + sinf(angle) * (bracelet_state.radius_px * 0.8f);
-        
-        circle_menu_add_circle(bracelet_state.menu, x, y, bracelet_state.bead_radius_px, NULL);
+    // Add circles to menu; render_bracelet lays them out when it is shown,
+    // so a document can be created without a window
+    for (uint32_t i = 0; i < doc->num_slots; i++) {
+        circle_menu_add_circle(doc->menu, 0, 0, doc->bead_radius_px, NULL);
     }
+    return doc;
 }
 
-BraceletConfig get_bracelet_config(void) {
-    return bracelet_state.config;
+BraceletConfig get_bracelet_config(BraceletDoc* doc) {
+    return doc->config;
 }
 
-void update_bracelet_config(BraceletConfig new_config) {
+void update_bracelet_config(BraceletDoc* doc, BraceletConfig new_config) {
     printf("Updating bracelet config - pattern: %d, group_size: %d, skip_size: %d\n", 
            new_config.selection.pattern, 
            new_config.selection.group_size,
            new_config.selection.skip_size);
            
-    bracelet_state.config = new_config;  // Make sure we're copying the entire config
+    doc->config = new_config;  // Make sure we're copying the entire config
 }
 
-int32_t find_hovered_bead(Clay_Vector2 pointer_pos) {
-    // Calculate bracelet center position (same as in render)
-    float center_x = GetScreenWidth() / 2;  // Fix: Use same center as render
-    float center_y = GetScreenHeight() / 2;
+// Radians added to each side of the hit test window for float rounding in the
+// slot angles and centers
+#define ANGLE_MARGIN 1e-4
 
-    //printf("Finding hover - Mouse at (%f, %f), Bracelet center at (%f, %f)\n", 
-    //       pointer_pos.x, pointer_pos.y, center_x, center_y);
+// Distance test shared by the angular window and the full scan
+static bool slot_contains(const BraceletGeometry* geometry, uint32_t slot, Clay_Vector2 pointer_pos) {
+    float dx = geometry->slots[slot].center.x - pointer_pos.x;
+    float dy = geometry->slots[slot].center.y - pointer_pos.y;
+    return sqrtf(dx * dx + dy * dy) <= geometry->slots[slot].radius_px;
+}
 
-    for (uint32_t i = 0; i < bracelet_state.num_slots; i++) {
-        // Calculate bead position
-        float angle = (float)i / bracelet_state.num_slots * (2.0f * M_PI);
-        float x = center_x + cosf(angle) * (bracelet_state.radius_px * 0.8f);
-        float y = center_y + sinf(angle) * (bracelet_state.radius_px * 0.8f);
-        
-        // Check distance from pointer to bead center
-        float dx = x - pointer_pos.x;
-        float dy = y - pointer_pos.y;
-        float distance = sqrtf(dx * dx + dy * dy);
-        
-        if (distance <= bracelet_state.bead_radius_px) {
-            printf("Found hover on bead %d (distance: %f)\n", i, distance);
-            return i;
+int32_t find_hovered_bead(BraceletDoc* doc, Clay_Vector2 pointer_pos) {
+    const BraceletGeometry* geometry = get_bracelet_geometry(doc);
+    uint32_t num_slots = geometry->num_slots;
+    if (num_slots == 0) return -1;
+
+    // Work in polar coordinates around the ring center: a slot can only hold
+    // the pointer if the pointer is within the largest bead radius of the
+    // ring, and then only slots within the angular half-width below of the
+    // pointer's angle
+    double dx = pointer_pos.x - geometry->center.x;
+    double dy = pointer_pos.y - geometry->center.y;
+    double distance = sqrt(dx * dx + dy * dy);
+    double ring = geometry->ring_radius_px;
+    double reach = geometry->max_radius_px;
+    // The margins keep the window a superset of the float distance test
+    if (fabs(distance - ring) > reach * 1.001 + 0.01) return -1;
+
+    double window_start = 0.0, window_width = 2.0 * M_PI;
+    if (distance > 0.0 && ring > 0.0) {
+        double cos_limit = (distance * distance + ring * ring - reach * reach) / (2.0 * distance * ring);
+        if (cos_limit > -1.0) {
+            double half_width = acos(cos_limit < 1.0 ? cos_limit : 1.0) + ANGLE_MARGIN;
+            double angle = atan2(dy, dx);
+            window_start = fmod(angle - half_width + 4.0 * M_PI, 2.0 * M_PI);
+            window_width = 2.0 * half_width;
+        }
+    }
+
+    // Beads that overlap the whole ring fall back to a full scan
+    int32_t hovered = -1;
+    if (window_width >= 2.0 * M_PI) {
+        for (uint32_t i = 0; i < num_slots && hovered < 0; i++) {
+            if (slot_contains(geometry, i, pointer_pos)) hovered = i;
+        }
+        return hovered;
+    }
+
+    // Slot angles increase with the index, so the window starts at the first
+    // slot at or past window_start and may wrap around slot 0; keep the lowest
+    // matching index like a full scan would
+    uint32_t low = 0, high = num_slots;
+    while (low < high) {
+        uint32_t mid = low + (high - low) / 2;
+        if (geometry->slots[mid].angle < window_start) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    for (uint32_t k = 0; k < num_slots; k++) {
+        uint32_t slot = (low + k) % num_slots;
+        double offset = geometry->slots[slot].angle - window_start;
+        if (offset < 0.0) offset += 2.0 * M_PI;
+        if (offset > window_width) break;
+        if ((hovered < 0 || (int32_t)slot < hovered) && slot_contains(geometry, slot, pointer_pos)) {
+            hovered = (int32_t)slot;
         }
     }
-    return -1;
+    return hovered;
 }
 
-void update_hovered_bead(Clay_Vector2 pointer_pos) {
-    bracelet_state.hovered_index = find_hovered_bead(pointer_pos);
+void update_hovered_bead(BraceletDoc* doc, Clay_Vector2 pointer_pos) {
+    doc->hovered_index = find_hovered_bead(doc, pointer_pos);
 }
 
-void place_bead(int32_t slot_index, Clay_Color color, uint32_t image_id, const char* bead_id) {
-    push_undo_state();  // Add this at the start
-    printf("Placing bead - slot: %d, image_id: %d, bead_id: %s\n", slot_index, image_id, bead_id);
-    
-    if (slot_index >= 0 && slot_index < bracelet_state.num_slots) {
-        bracelet_state.beads[slot_index].color = color;
-        bracelet_state.beads[slot_index].image_id = image_id;
-        bracelet_state.beads[slot_index].bead_id = (char*)bead_id;
-        printf("Bead placed successfully\n");
-    } else {
-        printf("Failed to place bead - invalid slot index\n");
+static bool record_slot_change(BraceletDoc* doc, uint32_t slot, BraceletBead before, BraceletBead after);
+static void free_undo_journal(UndoSystem* undo);
+
+// Put a bead in a valid slot and journal the edit. The edit is journaled
+// first, so one that could not be undone is not made at all.
+static bool set_slot_bead(BraceletDoc* doc, uint32_t slot, BeadHandle bead) {
+    BraceletBead before = doc->beads[slot];
+    BraceletBead after = before;
+    after.bead = bead;
+    if (!record_slot_change(doc, slot, before, after)) return false;
+    doc->beads[slot] = after;
+    mark_slots_resized(doc, slot, slot);
+    return true;
+}
+
+void place_bead(BraceletDoc* doc, int32_t slot_index, BeadHandle bead) {
+    place_beads(doc, &slot_index, 1, bead);
+}
+
+uint32_t place_beads(BraceletDoc* doc, const int32_t* slots, size_t count, BeadHandle bead) {
+    if (!slots) return 0;
+    uint32_t placed = 0;
+    begin_undo_transaction(doc);
+    for (size_t i = 0; i < count; i++) {
+        if (slots[i] >= 0 && (uint32_t)slots[i] < doc->num_slots && set_slot_bead(doc, slots[i], bead)) {
+            placed++;
+        }
     }
+    end_undo_transaction(doc);
+    return placed;
 }
 
-void get_selected_indices(int32_t hover_index, int32_t* out_indices, int* out_count) {
-    if (!out_indices || !out_count || hover_index < 0) return;
-    
-    *out_count = 0;
-    SelectionConfig selection = bracelet_state.config.selection;
-    
-    switch (selection.pattern) {
+// Grow the buffers to hold slots [0, num_slots); new bits start clear
+static bool reserve_slot_selection(SlotSelection* selection, uint32_t num_slots) {
+    if (num_slots <= selection->capacity) return true;
+    uint32_t old_words = (selection->capacity + 63) / 64;
+    uint32_t words = (num_slots + 63) / 64;
+    uint64_t* bits = realloc(selection->bits, words * sizeof(uint64_t));
+    if (!bits) return false;
+    memset(bits + old_words, 0, (words - old_words) * sizeof(uint64_t));
+    selection->bits = bits;
+    int32_t* indices = realloc(selection->indices, num_slots * sizeof(int32_t));
+    if (!indices) return false;
+    selection->indices = indices;
+    selection->capacity = num_slots;
+    return true;
+}
+
+bool add_slot_to_selection(SlotSelection* selection, uint32_t slot) {
+    if (!reserve_slot_selection(selection, slot + 1)) return false;
+    uint64_t mask = 1ull << (slot % 64);
+    if (!(selection->bits[slot / 64] & mask)) {
+        selection->bits[slot / 64] |= mask;
+        selection->indices[selection->count++] = (int32_t)slot;
+    }
+    return true;
+}
+
+bool is_slot_selected(const SlotSelection* selection, uint32_t slot) {
+    return slot < selection->capacity && (selection->bits[slot / 64] >> (slot % 64) & 1);
+}
+
+void clear_slot_selection(SlotSelection* selection) {
+    // Only the members' bits are set, so clearing costs the selection's size
+    for (uint32_t i = 0; i < selection->count; i++) {
+        uint32_t slot = (uint32_t)selection->indices[i];
+        selection->bits[slot / 64] &= ~(1ull << (slot % 64));
+    }
+    selection->count = 0;
+}
+
+void free_slot_selection(SlotSelection* selection) {
+    free(selection->bits);
+    free(selection->indices);
+    *selection = (SlotSelection){0};
+}
+
+bool get_selected_indices(BraceletDoc* doc, int32_t hover_index, SlotSelection* selection) {
+    if (!selection) return false;
+    clear_slot_selection(selection);
+    uint32_t num_slots = doc->num_slots;
+    if (hover_index < 0 || (uint32_t)hover_index >= num_slots) return true;
+    if (!reserve_slot_selection(selection, num_slots)) return false;
+
+    // Slots covered twice (a pattern that wraps past its start) are kept once
+    SelectionConfig pattern = doc->config.selection;
+    switch (pattern.pattern) {
         case PATTERN_SINGLE:
-            out_indices[(*out_count)++] = hover_index;
+            add_slot_to_selection(selection, hover_index);
             break;
             
         case PATTERN_GROUP:
-            for (int i = 0; i < selection.group_size && *out_count < bracelet_state.num_slots; i++) {
-                out_indices[(*out_count)++] = (hover_index + i) % bracelet_state.num_slots;
+            for (int i = 0; i < pattern.group_size && selection->count < num_slots; i++) {
+                add_slot_to_selection(selection, (hover_index + i) % num_slots);
             }
             break;
             
-        case PATTERN_ALTERNATE:
+        case PATTERN_ALTERNATE: {
             // Show full alternating pattern preview
-            int total_pattern = selection.group_size + selection.skip_size;
-            for (int pos = hover_index; pos < hover_index + bracelet_state.num_slots; pos += total_pattern) {
+            int total_pattern = pattern.group_size + pattern.skip_size;
+            if (total_pattern <= 0) break;
+            for (int64_t pos = hover_index; pos < (int64_t)hover_index + num_slots; pos += total_pattern) {
                 // Add the group at this position
-                for (int i = 0; i < selection.group_size && *out_count < bracelet_state.num_slots; i++) {
-                    out_indices[(*out_count)++] = (pos + i) % bracelet_state.num_slots;
+                for (int i = 0; i < pattern.group_size && selection->count < num_slots; i++) {
+                    add_slot_to_selection(selection, (pos + i) % num_slots);
                 }
             }
             break;
+        }
             
         case PATTERN_MAX:
-            for (int i = 0; i < bracelet_state.num_slots; i++) {
-                out_indices[(*out_count)++] = i;
+            for (uint32_t i = 0; i < num_slots; i++) {
+                add_slot_to_selection(selection, i);
             }
             break;
     }
+    return true;
 }
 
-void render_bracelet(BeadCollection* beads) {
-    float center_x = GetScreenWidth() / 2;
-    float center_y = GetScreenHeight() / 2;
+uint32_t place_beads_in_selection(BraceletDoc* doc, const SlotSelection* selection, BeadHandle bead) {
+    return selection ? place_beads(doc, selection->indices, selection->count, bead) : 0;
+}
+
+uint32_t place_beads_by_pattern(BraceletDoc* doc, int32_t start_index, BeadHandle bead) {
+    if (!get_selected_indices(doc, start_index, &doc->placement)) return 0;
+    return place_beads_in_selection(doc, &doc->placement, bead);
+}
+
+void render_bracelet(BraceletDoc* doc, BeadCollection* beads) {
+    update_bracelet_layout(doc, beads);
+    const BraceletGeometry* geometry = get_bracelet_geometry(doc);
+    float center_x = geometry->center.x;
+    float center_y = geometry->center.y;
 
     // Draw base circle
-    DrawCircle(center_x, center_y, bracelet_state.radius_px,
+    DrawCircle(center_x, center_y, doc->radius_px,
                (Color){120, 120, 140, 255});
 
-    // Get all highlighted indices based on current hover
-    int32_t highlighted_indices[24];  // Max number of beads
-    int highlighted_count = 0;
-    if (bracelet_state.hovered_index >= 0) {
-        get_selected_indices(bracelet_state.hovered_index, highlighted_indices, &highlighted_count);
-    }
+    // Get all highlighted slots based on current hover
+    get_selected_indices(doc, doc->hovered_index, &doc->highlight);
 
     // Draw bead slots and beads
-    for (uint32_t i = 0; i < bracelet_state.num_slots; i++) {
-        float angle = (float)i / bracelet_state.num_slots * (2.0f * M_PI);
-        float x = center_x + cosf(angle) * (bracelet_state.radius_px * 0.8f);
-        float y = center_y + sinf(angle) * (bracelet_state.radius_px * 0.8f);
+    for (uint32_t i = 0; i < geometry->num_slots; i++) {
+        float x = geometry->slots[i].center.x;
+        float y = geometry->slots[i].center.y;
+        float radius = geometry->slots[i].radius_px;
         
         // Draw bead slot
-        DrawCircle(x, y, bracelet_state.bead_radius_px,
+        DrawCircle(x, y, radius,
                   (Color){180, 180, 180, 255});  // Light gray for empty slots
         
-        // Draw bead if it exists
-        if (bracelet_state.beads[i].image_id > 0) {
+        // Draw bead if it exists; a slot whose bead is not in this catalog
+        // draws as empty
+        const BeadDefinition* bead = get_bead_by_handle(beads, doc->beads[i].bead);
+        if (bead && bead->image_id > 0) {
             // Draw bead with image
-            BeadImage* img = &bead_images[bracelet_state.beads[i].image_id - 1];
-            float scale = (bracelet_state.bead_radius_px * 2) / img->texture.width;
+            BeadImage* img = &bead_images[bead->image_id - 1];
+            float scale = (radius * 2) / img->texture.width;
             DrawTextureEx(
                 img->texture,
                 (Vector2){
-                    x - bracelet_state.bead_radius_px,
-                    y - bracelet_state.bead_radius_px
+                    x - radius,
+                    y - radius
                 },
                 0.0f,
                 scale,
@@ -217,27 +483,31 @@ void render_bracelet(BeadCollection* beads) {
             );
         } else {
             // Draw colored bead
-            DrawCircle(x, y, bracelet_state.bead_radius_px,
-                      *(Color*)&bracelet_state.beads[i].color);
+            Clay_Color color = bead ? bead->color : (Clay_Color){1.0f, 1.0f, 1.0f, 1.0f};
+            DrawCircle(x, y, radius, *(Color*)&color);
         }
         
         // Draw highlight for all selected slots
-        bool is_highlighted = false;
-        for (int j = 0; j < highlighted_count; j++) {
-            if (highlighted_indices[j] == i) {
-                is_highlighted = true;
-                break;
-            }
-        }
-        
-        if (is_highlighted) {
-            DrawCircleLines(x, y, bracelet_state.bead_radius_px + 2, BLUE);
-            DrawCircleLines(x, y, bracelet_state.bead_radius_px + 4, SKYBLUE);
+        if (is_slot_selected(&doc->highlight, i)) {
+            DrawCircleLines(x, y, radius + 2, BLUE);
+            DrawCircleLines(x, y, radius + 4, SKYBLUE);
         }
     }
 
+    // Warn when the beads do not fit the cord
+    const BraceletFit* fit = &doc->layout.fit;
+    if (doc->layout.valid && fit->status != BRACELET_FIT_OK) {
+        char label[64];
+        snprintf(label, sizeof(label), fit->status == BRACELET_FIT_OVERFILL ?
+                 "Overfilled by %.1f mm" : "%.1f mm left to fill",
+                 fabsf(fit->gap_mm));
+        int text_width = MeasureText(label, 20);
+        DrawText(label, center_x - text_width / 2, center_y - 10, 20,
+                 fit->status == BRACELET_FIT_OVERFILL ? RED : ORANGE);
+    }
+
     // Draw circle menu if visible
-    if (bracelet_state.circle_menu_visible) {
+    if (doc->circle_menu_visible) {
         // Draw panel background
         int panel_width = 200;
         int panel_height = GetScreenHeight();
@@ -250,7 +520,7 @@ void render_bracelet(BeadCollection* beads) {
                           (Color){180, 180, 180, 255});
         
         // Draw circles in grid layout
-        size_t count = circle_menu_get_count(bracelet_state.menu);
+        size_t count = circle_menu_get_count(doc->menu);
         int circles_per_row = 3;
         int circle_spacing = 20;
         int circle_size = (panel_width - (circles_per_row + 1) * circle_spacing) / circles_per_row;
@@ -265,10 +535,10 @@ void render_bracelet(BeadCollection* beads) {
             int y = start_y + row * (circle_size + circle_spacing);
             
             // Update circle position in the menu
-            circle_menu_update_position(bracelet_state.menu, i, x + circle_size/2, y + circle_size/2);
+            circle_menu_update_position(doc->menu, i, x + circle_size/2, y + circle_size/2);
             
             // Draw bead image if available
-            const char* bead_id = circle_menu_get_bead_id(bracelet_state.menu, i);
+            const char* bead_id = circle_menu_get_bead_id(doc->menu, i);
             if (bead_id) {
                 BeadDefinition* bead = find_bead_by_id(beads, bead_id);
                 if (bead && bead->image_id > 0) {
@@ -289,7 +559,7 @@ void render_bracelet(BeadCollection* beads) {
             }
             
             // Draw selection highlight if needed
-            if (circle_menu_is_selected(bracelet_state.menu, i)) {
+            if (circle_menu_is_selected(doc->menu, i)) {
                 DrawCircleLines(x + circle_size/2, y + circle_size/2, circle_size/2, BLUE);
                 DrawCircleLines(x + circle_size/2, y + circle_size/2, circle_size/2 + 2, SKYBLUE);
             }
@@ -297,13 +567,13 @@ void render_bracelet(BeadCollection* beads) {
     }
 
     // Draw knot if enabled
-    if (bracelet_state.config.has_knot) {
-        float knot_width_px = bracelet_state.config.knot_width_mm * MM_TO_PIXELS;
-        float knot_height_px = bracelet_state.config.knot_height_mm * MM_TO_PIXELS;
+    if (doc->config.has_knot) {
+        float knot_width_px = doc->config.knot_width_mm * MM_TO_PIXELS;
+        float knot_height_px = doc->config.knot_height_mm * MM_TO_PIXELS;
         
         // Calculate knot position
         float knot_x = center_x - knot_width_px/2;
-        float knot_y = center_y + bracelet_state.radius_px * 0.8f - knot_height_px/2;
+        float knot_y = center_y + geometry->ring_radius_px - knot_height_px/2;
         
         // Calculate knot label
         const char* label = "Knot";
@@ -327,30 +597,32 @@ void render_bracelet(BeadCollection* beads) {
     }
 }
 
-void cleanup_bracelet(void) {
-    if (bracelet_state.beads) {
-        free(bracelet_state.beads);
-        bracelet_state.beads = NULL;
-    }
-    circle_menu_destroy(bracelet_state.menu);
-    bracelet_state.menu = NULL;
-    bracelet_state.num_slots = 0;
+void free_bracelet_doc(BraceletDoc* doc) {
+    if (!doc) return;
+    free(doc->beads);
+    circle_menu_destroy(doc->menu);
+    free(doc->geometry.slots);
+    free_bracelet_layout(&doc->layout);
+    free_slot_selection(&doc->highlight);
+    free_slot_selection(&doc->placement);
+    free_undo_journal(&doc->undo);
+    free(doc);
 }
 
-void bracelet_toggle_circle_menu(void) {
-    bracelet_state.circle_menu_visible = !bracelet_state.circle_menu_visible;
+void bracelet_toggle_circle_menu(BraceletDoc* doc) {
+    doc->circle_menu_visible = !doc->circle_menu_visible;
 }
 
-bool is_circle_menu_visible(void) {
-    return bracelet_state.circle_menu_visible;
+bool is_circle_menu_visible(BraceletDoc* doc) {
+    return doc->circle_menu_visible;
 }
 
 // Add knot rendering function
-void render_knot(float center_x, float center_y, float radius) {
-    if (!bracelet_state.config.has_knot) return;
+void render_knot(BraceletDoc* doc, float center_x, float center_y, float radius) {
+    if (!doc->config.has_knot) return;
     
-    float knot_width = bracelet_state.config.knot_width_mm * MM_TO_PIXELS;
-    float knot_height = bracelet_state.config.knot_height_mm * MM_TO_PIXELS;
+    float knot_width = doc->config.knot_width_mm * MM_TO_PIXELS;
+    float knot_height = doc->config.knot_height_mm * MM_TO_PIXELS;
     
     // Draw square knot pattern
     float x = center_x - knot_width/2;
@@ -382,8 +654,8 @@ void render_knot(float center_x, float center_y, float radius) {
     }
     
     // Draw cord ends if enabled
-    if (bracelet_state.config.has_cord_ends) {
-        float cord_end_size = bracelet_state.bead_radius_px * 1.2f;
+    if (doc->config.has_cord_ends) {
+        float cord_end_size = doc->bead_radius_px * 1.2f;
         DrawCircle(
             x - cord_end_size,
             y + knot_height/2,
@@ -414,23 +686,23 @@ void render_knot(float center_x, float center_y, float radius) {
     );
 }
 
-bool save_bracelet_to_file(const char* filename) {
+bool save_bracelet_to_file(BraceletDoc* doc, const char* filename, BeadCollection* beads) {
     FILE* f = fopen(filename, "w");
     if (!f) return false;
     
     fprintf(f, "{\n");
-    fprintf(f, "  \"bead_count\": %d,\n", bracelet_state.config.bead_count);
-    fprintf(f, "  \"has_knot\": %s,\n", bracelet_state.config.has_knot ? "true" : "false");
-    fprintf(f, "  \"has_cord_ends\": %s,\n", bracelet_state.config.has_cord_ends ? "true" : "false");
+    fprintf(f, "  \"bead_count\": %d,\n", doc->config.bead_count);
+    fprintf(f, "  \"has_knot\": %s,\n", doc->config.has_knot ? "true" : "false");
+    fprintf(f, "  \"has_cord_ends\": %s,\n", doc->config.has_cord_ends ? "true" : "false");
     
     // Save beads
     fprintf(f, "  \"beads\": [\n");
-    for (uint32_t i = 0; i < bracelet_state.num_slots; i++) {
+    for (uint32_t i = 0; i < doc->num_slots; i++) {
+        const BeadDefinition* bead = get_bead_by_handle(beads, doc->beads[i].bead);
         fprintf(f, "    {\n");
-        fprintf(f, "      \"bead_id\": \"%s\",\n", 
-               bracelet_state.beads[i].bead_id ? bracelet_state.beads[i].bead_id : "");
-        fprintf(f, "      \"image_id\": %d\n", bracelet_state.beads[i].image_id);
-        fprintf(f, "    }%s\n", i < bracelet_state.num_slots - 1 ? "," : "");
+        fprintf(f, "      \"bead_id\": \"%s\",\n", bead && bead->id ? bead->id : "");
+        fprintf(f, "      \"image_id\": %d\n", bead ? bead->image_id : 0);
+        fprintf(f, "    }%s\n", i < doc->num_slots - 1 ? "," : "");
     }
     fprintf(f, "  ]\n");
     fprintf(f, "}\n");
@@ -439,70 +711,396 @@ bool save_bracelet_to_file(const char* filename) {
     return true;
 }
 
-bool load_bracelet_from_file(const char* filename) {
+bool load_bracelet_from_file(BraceletDoc* doc, const char* filename) {
     // TODO: Implement JSON parsing
     // For now, just a placeholder that resets to defaults
-    BraceletConfig config = get_bracelet_config();
+    BraceletConfig config = get_bracelet_config(doc);
     config.bead_count = 24;
     config.has_knot = true;
     config.has_cord_ends = false;
-    update_bracelet_config(config);
+    update_bracelet_config(doc, config);
     return true;
 }
 
-// Add undo/redo implementation
-void push_undo_state(void) {
-    if (!bracelet_state.undo.states) {
-        bracelet_state.undo.states = malloc(MAX_UNDO_STATES * sizeof(BraceletState_UndoEntry));
-        bracelet_state.undo.current = -1;
-        bracelet_state.undo.count = 0;
+// Undo journal: each entry holds only the slots its transaction changed
+
+// Smallest ring allocated; it doubles from here up to the budget, so a
+// document with little history holds little memory
+#define MIN_UNDO_RING_CHANGES 256
+
+static BraceletState_UndoEntry* undo_entry(UndoSystem* undo, int step) {
+    return &undo->states[(undo->first + (uint32_t)step) % undo->states_capacity];
+}
+
+static void reset_undo_ring(UndoSystem* undo) {
+    undo->first = 0;
+    undo->count = 0;
+    undo->current = 0;
+    undo->ring_head = 0;
+    undo->ring_tail = 0;
+    undo->bytes_held = 0;
+}
+
+static void truncate_redo_entries(UndoSystem* undo);
+
+// Drop the oldest step. Its changes are reclaimed by moving the ring's head.
+static void evict_oldest_undo_entry(UndoSystem* undo) {
+    if (undo->current == 0) {
+        // Every step is undone: without the oldest the rest cannot be redone
+        undo->states_evicted += undo->count;
+        truncate_redo_entries(undo);
+        return;
+    }
+    undo->bytes_held -= undo_entry(undo, 0)->num_changes * sizeof(BraceletSlotChange);
+    undo->first = (undo->first + 1) % undo->states_capacity;
+    undo->count--;
+    undo->current--;
+    undo->states_evicted++;
+    if (undo->count == 0) {
+        reset_undo_ring(undo);
+    } else {
+        undo->ring_head = undo_entry(undo, 0)->offset;
+    }
+}
+
+// Drop the steps that can be redone; their changes were the newest in the ring
+static void truncate_redo_entries(UndoSystem* undo) {
+    for (int i = undo->current; i < undo->count; i++) {
+        undo->bytes_held -= undo_entry(undo, i)->num_changes * sizeof(BraceletSlotChange);
+    }
+    undo->count = undo->current;
+    if (undo->count == 0) {
+        reset_undo_ring(undo);
+    } else {
+        BraceletState_UndoEntry* newest = undo_entry(undo, undo->count - 1);
+        undo->ring_tail = newest->offset + newest->num_changes;
     }
+}
 
-    // Remove any redo states
-    bracelet_state.undo.count = bracelet_state.undo.current + 1;
+// Ring size in changes that the budget allows
+static uint32_t get_undo_budget_changes(const UndoSystem* undo) {
+    size_t capacity = undo->budget_bytes / sizeof(BraceletSlotChange);
+    return capacity > UINT32_MAX ? UINT32_MAX : (uint32_t)capacity;
+}
 
-    // Shift states if we're at max capacity
-    if (bracelet_state.undo.count >= MAX_UNDO_STATES) {
-        memmove(&bracelet_state.undo.states[0], 
-                &bracelet_state.undo.states[1], 
-                (MAX_UNDO_STATES - 1) * sizeof(BraceletState_UndoEntry));
-        bracelet_state.undo.count--;
-        bracelet_state.undo.current--;
+// Move the steps to a new ring of the given capacity, packed from its start.
+// The steps held must fit.
+static bool resize_undo_ring(UndoSystem* undo, uint32_t capacity) {
+    BraceletSlotChange* ring = malloc((size_t)capacity * sizeof(BraceletSlotChange));
+    if (!ring) return false;
+    uint32_t offset = 0;
+    for (int i = 0; i < undo->count; i++) {
+        BraceletState_UndoEntry* state = undo_entry(undo, i);
+        memcpy(&ring[offset], &undo->ring[state->offset], state->num_changes * sizeof(BraceletSlotChange));
+        state->offset = offset;
+        offset += state->num_changes;
     }
+    free(undo->ring);
+    undo->ring = ring;
+    undo->ring_capacity = capacity;
+    undo->ring_head = 0;
+    undo->ring_tail = offset;
+    return true;
+}
 
-    // Create new state
-    BraceletState_UndoEntry* new_state = &bracelet_state.undo.states[bracelet_state.undo.count];
-    new_state->beads = malloc(bracelet_state.num_slots * sizeof(BraceletBead));
-    new_state->num_slots = bracelet_state.num_slots;
-    new_state->timestamp = time(NULL);
+// Find n contiguous free changes without evicting anything.
+// A step never wraps: if it does not fit before the end it starts at 0.
+static bool find_undo_span(UndoSystem* undo, uint32_t n, uint32_t* offset) {
+    if (undo->count == 0) {
+        *offset = 0;
+        return n <= undo->ring_capacity;
+    }
+    // Steps occupy [head, tail) if tail is past head, otherwise they wrap
+    // and [tail, head) is free; tail == head means the ring is full
+    if (undo->ring_tail > undo->ring_head) {
+        if (undo->ring_capacity - undo->ring_tail >= n) {
+            *offset = undo->ring_tail;
+            return true;
+        }
+        if (undo->ring_head >= n) {
+            *offset = 0;
+            return true;
+        }
+    } else if (undo->ring_tail < undo->ring_head && undo->ring_head - undo->ring_tail >= n) {
+        *offset = undo->ring_tail;
+        return true;
+    }
+    return false;
+}
 
-    // Copy current state
-    memcpy(new_state->beads, bracelet_state.beads, 
-           bracelet_state.num_slots * sizeof(BraceletBead));
+// Find room for n contiguous changes, growing the ring while the budget
+// allows and evicting the oldest steps once it does not
+static bool reserve_undo_span(UndoSystem* undo, uint32_t n, uint32_t* offset) {
+    uint32_t budget = get_undo_budget_changes(undo);
+    if (n > budget) return false;
+    while (!find_undo_span(undo, n, offset)) {
+        if (undo->ring_capacity < budget) {
+            uint32_t held = (uint32_t)(undo->bytes_held / sizeof(BraceletSlotChange));
+            uint64_t capacity = (uint64_t)undo->ring_capacity * 2;
+            if (capacity < (uint64_t)held + n) capacity = (uint64_t)held + n;
+            if (capacity < MIN_UNDO_RING_CHANGES) capacity = MIN_UNDO_RING_CHANGES;
+            if (capacity > budget) capacity = budget;
+            if (resize_undo_ring(undo, (uint32_t)capacity)) continue;
+        }
+        if (undo->count == 0) return false;
+        evict_oldest_undo_entry(undo);
+    }
+    return true;
+}
+
+// Make room for one more step descriptor, keeping the ring order
+static bool reserve_undo_entry(UndoSystem* undo) {
+    if ((uint32_t)undo->count < undo->states_capacity) return true;
+
+    uint32_t capacity = undo->states_capacity ? undo->states_capacity * 2 : 64;
+    BraceletState_UndoEntry* states = malloc(capacity * sizeof(BraceletState_UndoEntry));
+    if (!states) return false;
+    for (int i = 0; i < undo->count; i++) {
+        states[i] = *undo_entry(undo, i);
+    }
+    free(undo->states);
+    undo->states = states;
+    undo->states_capacity = capacity;
+    undo->first = 0;
+    return true;
+}
 
-    bracelet_state.undo.current++;
-    bracelet_state.undo.count++;
-    bracelet_state.last_change = new_state->timestamp;
+void begin_undo_transaction(BraceletDoc* doc) {
+    doc->undo.transaction_depth++;
 }
 
-void undo_action(void) {
-    if (bracelet_state.undo.current <= 0) return;
+void end_undo_transaction(BraceletDoc* doc) {
+    UndoSystem* undo = &doc->undo;
+    if (undo->transaction_depth == 0 || --undo->transaction_depth > 0) return;
+    uint32_t n = undo->pending_count;
+    if (n == 0) return;
+    undo->pending_count = 0;
 
-    bracelet_state.undo.current--;
-    BraceletState_UndoEntry* state = &bracelet_state.undo.states[bracelet_state.undo.current];
-    
-    // Restore state
-    memcpy(bracelet_state.beads, state->beads,
-           state->num_slots * sizeof(BraceletBead));
+    doc->last_change = time(NULL);
+    doc->has_unsaved_changes = true;
+
+    // A new step replaces anything that could be redone
+    truncate_redo_entries(undo);
+
+    // A step larger than the whole budget cannot be undone; the older history
+    // would no longer lead back to the current beads, so it goes too
+    uint32_t offset;
+    if (!reserve_undo_entry(undo) || !reserve_undo_span(undo, n, &offset)) {
+        while (undo->count > 0) evict_oldest_undo_entry(undo);
+        return;
+    }
+
+    memcpy(&undo->ring[offset], undo->pending, n * sizeof(BraceletSlotChange));
+    if (undo->count == 0) undo->ring_head = offset;
+    undo->ring_tail = offset + n;
+    undo->count++;
+    *undo_entry(undo, undo->count - 1) = (BraceletState_UndoEntry){
+        .offset = offset,
+        .num_changes = n,
+        .timestamp = doc->last_change
+    };
+    undo->current = undo->count;
+    undo->bytes_held += n * sizeof(BraceletSlotChange);
 }
 
-void redo_action(void) {
-    if (bracelet_state.undo.current >= bracelet_state.undo.count - 1) return;
+static bool same_bead(BraceletBead a, BraceletBead b) {
+    return a.bead.index == b.bead.index && a.bead.generation == b.bead.generation;
+}
 
-    bracelet_state.undo.current++;
-    BraceletState_UndoEntry* state = &bracelet_state.undo.states[bracelet_state.undo.current];
-    
-    // Restore state
-    memcpy(bracelet_state.beads, state->beads,
-           state->num_slots * sizeof(BraceletBead));
-} 
\ No newline at end of file
+// Journal one slot edit into the open transaction, or as its own step.
+// Returns false if there was no room to journal it.
+static bool record_slot_change(BraceletDoc* doc, uint32_t slot, BraceletBead before, BraceletBead after) {
+    if (same_bead(before, after)) return true;
+
+    UndoSystem* undo = &doc->undo;
+    if (undo->pending_count == undo->pending_capacity) {
+        uint32_t capacity = undo->pending_capacity ? undo->pending_capacity * 2 : 16;
+        BraceletSlotChange* pending = realloc(undo->pending, capacity * sizeof(BraceletSlotChange));
+        if (!pending) return false;
+        undo->pending = pending;
+        undo->pending_capacity = capacity;
+    }
+    begin_undo_transaction(doc);
+    undo->pending[undo->pending_count++] = (BraceletSlotChange){ slot, before, after };
+    end_undo_transaction(doc);
+    return true;
+}
+
+void undo_action(BraceletDoc* doc) {
+    UndoSystem* undo = &doc->undo;
+    if (undo->transaction_depth > 0 || undo->current <= 0) return;
+
+    // Replay the step's edits backwards so a slot edited twice ends at its first value
+    BraceletState_UndoEntry* state = undo_entry(undo, --undo->current);
+    const BraceletSlotChange* changes = &undo->ring[state->offset];
+    for (uint32_t i = state->num_changes; i-- > 0;) {
+        if (changes[i].slot < doc->num_slots) {
+            doc->beads[changes[i].slot] = changes[i].before;
+            mark_slots_resized(doc, changes[i].slot, changes[i].slot);
+        }
+    }
+    doc->has_unsaved_changes = true;
+}
+
+void redo_action(BraceletDoc* doc) {
+    UndoSystem* undo = &doc->undo;
+    if (undo->transaction_depth > 0 || undo->current >= undo->count) return;
+
+    BraceletState_UndoEntry* state = undo_entry(undo, undo->current++);
+    const BraceletSlotChange* changes = &undo->ring[state->offset];
+    for (uint32_t i = 0; i < state->num_changes; i++) {
+        if (changes[i].slot < doc->num_slots) {
+            doc->beads[changes[i].slot] = changes[i].after;
+            mark_slots_resized(doc, changes[i].slot, changes[i].slot);
+        }
+    }
+    doc->has_unsaved_changes = true;
+}
+
+void set_undo_budget(BraceletDoc* doc, size_t budget_bytes) {
+    UndoSystem* undo = &doc->undo;
+    undo->budget_bytes = budget_bytes;
+    if (!undo->ring) return;
+
+    // Keep the newest steps that fit, packed from the start of a smaller ring;
+    // a larger budget only lets the ring grow further
+    uint32_t budget = get_undo_budget_changes(undo);
+    while (undo->bytes_held > (size_t)budget * sizeof(BraceletSlotChange)) {
+        evict_oldest_undo_entry(undo);
+    }
+    if (budget == 0) {
+        free(undo->ring);
+        undo->ring = NULL;
+        undo->ring_capacity = 0;
+    } else if (undo->ring_capacity > budget && !resize_undo_ring(undo, budget)) {
+        while (undo->count > 0) evict_oldest_undo_entry(undo);
+        free(undo->ring);
+        undo->ring = NULL;
+        undo->ring_capacity = 0;
+    }
+}
+
+BraceletUndoStats get_undo_stats(BraceletDoc* doc) {
+    UndoSystem* undo = &doc->undo;
+    return (BraceletUndoStats){
+        .bytes_held = undo->bytes_held,
+        .budget_bytes = undo->budget_bytes,
+        .states_evicted = undo->states_evicted,
+        .states = (uint32_t)undo->count
+    };
+}
+
+static void free_undo_journal(UndoSystem* undo) {
+    free(undo->ring);
+    free(undo->states);
+    free(undo->pending);
+    *undo = (UndoSystem){0};
+}
+
+// Workspace of open documents
+
+BraceletWorkspace* create_bracelet_workspace(void) {
+    BraceletWorkspace* workspace = calloc(1, sizeof(BraceletWorkspace));
+    if (workspace) workspace->active = -1;
+    return workspace;
+}
+
+BraceletDoc* open_bracelet_doc(BraceletWorkspace* workspace, BraceletConfig config) {
+    if (!workspace) return NULL;
+    if (workspace->count == workspace->capacity) {
+        uint32_t capacity = workspace->capacity ? workspace->capacity * 2 : 8;
+        BraceletDoc** docs = realloc(workspace->docs, capacity * sizeof(BraceletDoc*));
+        if (!docs) return NULL;
+        workspace->docs = docs;
+        workspace->capacity = capacity;
+    }
+    BraceletDoc* doc = create_bracelet_doc(config);
+    if (!doc) return NULL;
+    workspace->docs[workspace->count++] = doc;
+    if (workspace->active < 0) workspace->active = 0;
+    return doc;
+}
+
+void close_bracelet_doc(BraceletWorkspace* workspace, BraceletDoc* doc) {
+    if (!workspace || !doc) return;
+    for (uint32_t i = 0; i < workspace->count; i++) {
+        if (workspace->docs[i] != doc) continue;
+        memmove(&workspace->docs[i], &workspace->docs[i + 1],
+                (workspace->count - i - 1) * sizeof(BraceletDoc*));
+        workspace->count--;
+        // Keep the same document active; closing it activates its neighbour
+        if (workspace->active > (int32_t)i || workspace->active == (int32_t)workspace->count) {
+            workspace->active--;
+        }
+        free_bracelet_doc(doc);
+        return;
+    }
+}
+
+BraceletDoc* get_active_bracelet_doc(BraceletWorkspace* workspace) {
+    if (!workspace || workspace->active < 0) return NULL;
+    return workspace->docs[workspace->active];
+}
+
+void set_active_bracelet_doc(BraceletWorkspace* workspace, BraceletDoc* doc) {
+    if (!workspace) return;
+    for (uint32_t i = 0; i < workspace->count; i++) {
+        if (workspace->docs[i] == doc) {
+            workspace->active = (int32_t)i;
+            return;
+        }
+    }
+}
+
+// Document batches run on threads of their own rather than the bead worker
+// pool: the pool serializes its callers, so a batch on it would block catalog
+// queries from the UI, and a document that queries a large catalog would wait
+// on the pool it is already running on
+#define MAX_BRACELET_DOC_THREADS 16
+
+typedef struct {
+    BraceletWorkspace* workspace;
+    void (*process)(BraceletDoc* doc, void* context);
+    void* context;
+    uint32_t next_doc;  // Next unclaimed document, taken atomically
+} BraceletDocJob;
+
+static void* process_bracelet_doc_worker(void* arg) {
+    BraceletDocJob* job = arg;
+    uint32_t index;
+    while ((index = __atomic_fetch_add(&job->next_doc, 1, __ATOMIC_RELAXED)) < job->workspace->count) {
+        job->process(job->workspace->docs[index], job->context);
+    }
+    return NULL;
+}
+
+void process_bracelet_docs(BraceletWorkspace* workspace,
+                           void (*process)(BraceletDoc* doc, void* context), void* context) {
+    if (!workspace || !process) return;
+    // Documents share nothing, so no locking is needed beyond claiming them
+    BraceletDocJob job = { workspace, process, context, 0 };
+    uint32_t wanted = get_bead_cpu_count();
+    if (wanted > workspace->count) wanted = workspace->count;
+    if (wanted > MAX_BRACELET_DOC_THREADS) wanted = MAX_BRACELET_DOC_THREADS;
+
+    pthread_t threads[MAX_BRACELET_DOC_THREADS];
+    uint32_t started = 0;
+    // The caller takes documents too, so start one thread fewer
+    while (started + 1 < wanted &&
+           pthread_create(&threads[started], NULL, process_bracelet_doc_worker, &job) == 0) {
+        started++;
+    }
+    process_bracelet_doc_worker(&job);
+    for (uint32_t i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+void free_bracelet_workspace(BraceletWorkspace* workspace) {
+    if (!workspace) return;
+    for (uint32_t i = 0; i < workspace->count; i++) {
+        free_bracelet_doc(workspace->docs[i]);
+    }
+    free(workspace->docs);
+    free(workspace);
+}
@@ -8,7 +8,7 @@
 #include <time.h>
 
 #define MM_TO_PIXELS 3.0f  // Rough conversion from mm to pixels
-#define MAX_UNDO_STATES 50
+#define BRACELET_UNDO_DEFAULT_BUDGET (1u << 20)  // Bytes of undo history kept by default
 
 // Forward declarations
 struct BraceletState_UndoEntry;
@@ -21,6 +21,12 @@ typedef struct UndoSystem UndoSystem;
 typedef struct BraceletBead BraceletBead;
 typedef struct BraceletState BraceletState;
 
+// An open design: its slots, settings, undo history and view state. Nothing
+// is shared between documents, so different documents may be used on
+// different threads at once; each document is used by one thread at a time.
+// Rendering and hit testing read the window and stay on the main thread.
+typedef struct BraceletState BraceletDoc;
+
 // Update the pattern types
 typedef enum {
     PATTERN_SINGLE,      // Select one bead at a time
@@ -58,25 +64,120 @@ typedef struct {
 } BraceletConfig;
 
 // Define the actual structs
+// A slot refers to its bead by catalog handle; color, image and id are read
+// from the catalog when needed. A null handle is an empty slot.
 struct BraceletBead {
-    Clay_Vector2 position;
-    Clay_Color color;
-    uint32_t image_id;  // 0 means no image
-    char* bead_id;      // Unique identifier for the bead type
+    BeadHandle bead;
 };
 
+// One slot edit recorded by the undo journal
+typedef struct {
+    uint32_t slot;
+    BraceletBead before;
+    BraceletBead after;
+} BraceletSlotChange;
+
+// One undo step: the slot edits of one transaction, undone and redone together.
+// Its changes sit contiguously in the undo ring.
 struct BraceletState_UndoEntry {
-    BraceletBead* beads;
-    uint32_t num_slots;
+    uint32_t offset;       // Index of the first change in UndoSystem.ring
+    uint32_t num_changes;
     time_t timestamp;
 };
 
+// Undo history in a ring of changes that grows up to a byte budget. Recording
+// a step that does not fit once the ring is at its budget evicts the oldest
+// steps; nothing is freed per step.
 struct UndoSystem {
-    BraceletState_UndoEntry* states;
-    int current;
+    BraceletSlotChange* ring;        // Changes of every step, oldest first, wrapping
+    uint32_t ring_capacity;          // In changes
+    uint32_t ring_head;              // First change of the oldest step
+    uint32_t ring_tail;              // Where the next step's changes go
+    size_t budget_bytes;             // Largest ring size; 0 keeps no history
+    BraceletState_UndoEntry* states; // Ring of steps, oldest at states[first]
+    uint32_t states_capacity;
+    uint32_t first;
+    int current;                     // Number of steps currently applied
     int count;
+    BraceletSlotChange* pending;     // Edits of the open transaction; reused
+    uint32_t pending_count;
+    uint32_t pending_capacity;
+    int transaction_depth;           // Nesting level of begin_undo_transaction
+    size_t bytes_held;               // Bytes of changes held by recorded steps
+    uint64_t states_evicted;         // Steps dropped to stay within the budget
 };
 
+typedef struct {
+    size_t bytes_held;
+    size_t budget_bytes;
+    uint64_t states_evicted;
+    uint32_t states;
+} BraceletUndoStats;
+
+// A set of slots: a bitset for constant-time membership tests plus the
+// members in the order they were added. Zero-initialize before first use.
+typedef struct {
+    uint64_t* bits;
+    int32_t* indices;
+    uint32_t count;
+    uint32_t capacity;  // Slots the buffers are sized for
+} SlotSelection;
+
+// Screen geometry of one slot on the ring
+typedef struct {
+    Clay_Vector2 center;     // Slot center in screen pixels
+    Clay_Vector2 direction;  // Unit vector from the ring center (cos, sin of angle)
+    float angle;             // Radians, clockwise from the +x axis; increases with the slot
+    float radius_px;         // Drawn and hit tested radius, from the bead's size
+} BraceletSlotGeometry;
+
+// Slot table shared by rendering, hit testing and the circle menu. Rebuilt
+// when the slot count, ring radius or window size changes; when the layout
+// moves slots, only those are recomputed.
+typedef struct {
+    BraceletSlotGeometry* slots;
+    uint32_t num_slots;
+    uint32_t capacity;
+    Clay_Vector2 center;     // Ring center in screen pixels
+    float ring_radius_px;    // Distance from the ring center to the slot centers
+    float max_radius_px;     // Largest slot radius_px
+    int screen_width;
+    int screen_height;
+    bool valid;
+} BraceletGeometry;
+
+typedef enum {
+    BRACELET_FIT_OK,
+    BRACELET_FIT_UNDERFILL,  // A gap of more than half a bead is left on the cord
+    BRACELET_FIT_OVERFILL    // The beads need more than half a bead beyond the cord
+} BraceletFitStatus;
+
+typedef struct {
+    BraceletFitStatus status;
+    float length_mm;         // Beads end to end
+    float circumference_mm;  // Cord length: pi * bracelet_diameter_mm
+    float gap_mm;            // circumference_mm - length_mm; negative when overfilled
+} BraceletFit;
+
+// Slots packed along the cord by the size of their beads. Positions are
+// prefix sums, so an edit only recomputes the slots from it onward, and
+// stops early once the slots after the edit no longer move.
+typedef struct {
+    float* size_mm;              // Per slot; an empty slot is config.bead_size_mm
+    float* start_mm;             // Cord position where each slot starts; [num_slots] is the total
+    uint32_t num_slots;
+    uint32_t capacity;
+    uint32_t dirty_from;         // Slots [dirty_from, dirty_to] changed bead since the last update
+    uint32_t dirty_to;
+    uint32_t moved_from;         // First slot the geometry has yet to move
+    uint32_t catalog_generation; // Catalog the sizes were read from, 0 for none
+    float default_size_mm;
+    float max_size_mm;
+    float span_mm;               // Arc mapped to the full ring: the larger of length and circumference
+    BraceletFit fit;
+    bool valid;
+} BraceletLayout;
+
 struct BraceletState {
     float radius_px;        // Bracelet radius in pixels
     float bead_radius_px;   // Bead radius in pixels
@@ -92,35 +193,97 @@ struct BraceletState {
     char current_file[256];
     UndoSystem undo;
     time_t last_change;
+    BraceletGeometry geometry;  // Use get_bracelet_geometry, which keeps it current
+    BraceletLayout layout;      // Updated by update_bracelet_layout
+    SlotSelection highlight;    // Slots highlighted for the hovered slot, reused per frame
+    SlotSelection placement;    // Slots filled by place_beads_by_pattern, reused per call
 };
 
+// Open documents. The active one is the document shown in the window.
+typedef struct {
+    BraceletDoc** docs;
+    uint32_t count;
+    uint32_t capacity;
+    int32_t active;     // Index into docs, -1 when none is open
+} BraceletWorkspace;
+
 // Function declarations
-void initialize_bracelet(Clay_Arena* arena, BraceletConfig config);
-void cleanup_bracelet(void);
-void render_bracelet(BeadCollection* beads);
-void update_hovered_bead(Clay_Vector2 pointer_pos);
-int32_t find_hovered_bead(Clay_Vector2 pointer_pos);
-void place_bead(int32_t slot_index, Clay_Color color, uint32_t image_id, const char* bead_id);
-BraceletConfig get_bracelet_config(void);
-void update_bracelet_config(BraceletConfig new_config);
-
-// Get array of selected indices based on current pattern
-void get_selected_indices(int32_t hover_index, int32_t* out_indices, int* out_count);
+BraceletDoc* create_bracelet_doc(BraceletConfig config);
+void free_bracelet_doc(BraceletDoc* doc);
+void render_bracelet(BraceletDoc* doc, BeadCollection* beads);
+void update_hovered_bead(BraceletDoc* doc, Clay_Vector2 pointer_pos);
+int32_t find_hovered_bead(BraceletDoc* doc, Clay_Vector2 pointer_pos);
+const BraceletGeometry* get_bracelet_geometry(BraceletDoc* doc);
 
-// Add to existing declarations
-void bracelet_toggle_circle_menu(void);
-bool is_circle_menu_visible(void);
+// Pack the slots by the size_mm of their beads in beads, recomputing from the
+// first slot edited since the last call. With no catalog every slot is
+// config.bead_size_mm. render_bracelet calls this; the geometry uses the
+// layout as last updated.
+void update_bracelet_layout(BraceletDoc* doc, BeadCollection* beads);
+
+// How the beads fill the cord, as of the last update_bracelet_layout
+BraceletFit get_bracelet_fit(BraceletDoc* doc);
+// Put bead in one slot; an invalid slot is ignored
+void place_bead(BraceletDoc* doc, int32_t slot_index, BeadHandle bead);
+BraceletConfig get_bracelet_config(BraceletDoc* doc);
+void update_bracelet_config(BraceletDoc* doc, BraceletConfig new_config);
 
-// Declare the extern variable
-extern BraceletState bracelet_state;
+// Select the slots the current pattern covers from hover_index, replacing
+// the selection's contents. Returns false if the selection could not grow.
+bool get_selected_indices(BraceletDoc* doc, int32_t hover_index, SlotSelection* selection);
+
+// Slot selection sets
+bool add_slot_to_selection(SlotSelection* selection, uint32_t slot);
+bool is_slot_selected(const SlotSelection* selection, uint32_t slot);
+void clear_slot_selection(SlotSelection* selection);
+void free_slot_selection(SlotSelection* selection);
+
+// Put bead in many slots at once: one pass, one undo step, and the design is
+// marked changed once. Invalid slots are skipped; a null handle empties the
+// slots. Return the slots placed.
+uint32_t place_beads(BraceletDoc* doc, const int32_t* slots, size_t count, BeadHandle bead);
+uint32_t place_beads_in_selection(BraceletDoc* doc, const SlotSelection* selection, BeadHandle bead);
+
+// Fill the slots the current selection pattern covers from start_index
+uint32_t place_beads_by_pattern(BraceletDoc* doc, int32_t start_index, BeadHandle bead);
+
+// Add to existing declarations
+void bracelet_toggle_circle_menu(BraceletDoc* doc);
+bool is_circle_menu_visible(BraceletDoc* doc);
 
 // Add these declarations
-bool save_bracelet_to_file(const char* filename);
-bool load_bracelet_from_file(const char* filename);
+bool save_bracelet_to_file(BraceletDoc* doc, const char* filename, BeadCollection* beads);
+bool load_bracelet_from_file(BraceletDoc* doc, const char* filename);
+
+// Undo journal. Edits between begin_undo_transaction and the matching
+// end_undo_transaction become one undo step; transactions nest, and an edit
+// made outside any transaction is a step of its own.
+void begin_undo_transaction(BraceletDoc* doc);
+void end_undo_transaction(BraceletDoc* doc);
+void undo_action(BraceletDoc* doc);
+void redo_action(BraceletDoc* doc);
+
+// Bytes of history to keep (BRACELET_UNDO_DEFAULT_BUDGET by default). The
+// history grows into its budget as it is used. Shrinking keeps the newest
+// steps that fit.
+void set_undo_budget(BraceletDoc* doc, size_t budget_bytes);
+BraceletUndoStats get_undo_stats(BraceletDoc* doc);
+
+// Workspace. Documents are created by open_bracelet_doc and freed by
+// close_bracelet_doc or free_bracelet_workspace; the first one opened
+// becomes active.
+BraceletWorkspace* create_bracelet_workspace(void);
+BraceletDoc* open_bracelet_doc(BraceletWorkspace* workspace, BraceletConfig config);
+void close_bracelet_doc(BraceletWorkspace* workspace, BraceletDoc* doc);
+BraceletDoc* get_active_bracelet_doc(BraceletWorkspace* workspace);
+void set_active_bracelet_doc(BraceletWorkspace* workspace, BraceletDoc* doc);
+void free_bracelet_workspace(BraceletWorkspace* workspace);
 
-// Add function declarations
-void push_undo_state(void);
-void undo_action(void);
-void redo_action(void);
+// Run process(doc, context) for every open document, spread over up to one
+// thread per core; returns once all have finished. process must only touch
+// its own document, and must not render or hit test. It may run catalog
+// queries, which use the bead worker pool as usual.
+void process_bracelet_docs(BraceletWorkspace* workspace,
+                           void (*process)(BraceletDoc* doc, void* context), void* context);
 
 #endif
\ No newline at end of file
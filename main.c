@@ -3,18 +3,20 @@
 #include "raylib.h"
 #define RAYGUI_IMPLEMENTATION
 #include "raygui.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>  // for malloc/free
 #include <string.h>  // for strcmp
 #include "bracelet.h"
 #include "bead.h"
+#include "bead_search.h"
+#include "bead_import.h"
+#include "bead_catalog_file.h"
+#include "bead_snapshot.h"
 #include "bead_image.h"
 #include "surreal_client.h"
 #include "tinyfiledialogs.h"
 
-// At the top of main.c, add:
-extern BraceletState bracelet_state;  // Declare the external bracelet state
-
 // Clay Raylib renderer state
 typedef struct {
     void* unused;  // We don't actually need any state for the raylib renderer
@@ -101,6 +103,9 @@ Clay_TextElementConfig TITLE_TEXT_CONFIG = {
 BeadImage bead_images[MAX_BEAD_IMAGES] = {0};
 int num_bead_images = 0;
 
+// Catalog opened at startup when present, and the default export name
+#define BEAD_CATALOG_PATH "beads.catalog"
+
 // Button ID buffer
 #define MAX_BUTTON_ID_LENGTH 32
 static char button_id_buffer[MAX_BUTTON_ID_LENGTH];
@@ -112,6 +117,204 @@ static Clay_Raylib_State clay_raylib_state = {0};
 static char group_text_buffer[8] = "1";
 static char skip_text_buffer[8] = "0";
 
+// Palette search: while the box holds text the palette lists the best matches
+#define MAX_SEARCH_RESULTS 64
+#define MAX_SEARCH_MENU_BEADS 6   // Results Enter sends to the circle menu
+static char search_text_buffer[64] = "";
+static bool search_box_active = false;
+static bool search_dirty = false;
+static BeadSearchResult search_results[MAX_SEARCH_RESULTS];
+static uint32_t search_result_count = 0;
+// Catalog and generation the results were computed for. Versions of one
+// catalog share catalog_generation, and every insert bumps generation.
+static uint32_t search_catalog_generation = 0;
+static uint64_t search_generation = 0;
+
+// Re-run the palette search when the query or the collection changed. Prefix
+// matches suit typing; fall back to fuzzy matching to forgive typos.
+static void refresh_bead_search(BeadCollection* beads) {
+    if (!search_dirty && beads->catalog_generation == search_catalog_generation &&
+        beads->generation == search_generation) return;
+    search_dirty = false;
+    search_catalog_generation = beads->catalog_generation;
+    search_generation = beads->generation;
+    search_result_count = 0;
+    if (search_text_buffer[0]) {
+        search_result_count = search_beads(beads, search_text_buffer, BEAD_SEARCH_PREFIX,
+                                           search_results, MAX_SEARCH_RESULTS);
+        if (search_result_count == 0) {
+            search_result_count = search_beads(beads, search_text_buffer, BEAD_SEARCH_FUZZY,
+                                               search_results, MAX_SEARCH_RESULTS);
+        }
+    }
+}
+
+// Report feed import progress on stdout, about every 10%
+static void print_import_progress(const BeadImportProgress* progress, void* user_data) {
+    static int reported_percent = -10;
+    (void)user_data;
+    bool done = progress->bytes_read >= progress->total_bytes;
+    int percent = done ? 100 : (int)(progress->bytes_read * 100 / progress->total_bytes);
+    if (done || percent >= reported_percent + 10) {
+        printf("Importing beads: %d%% (%llu rows)\n", percent, (unsigned long long)progress->rows);
+        reported_percent = done ? -10 : percent;
+    }
+}
+
+// Supplier feed import, run on its own thread so the window stays responsive.
+// The feed is parsed into a private collection and only merged into the catalog
+// at the end, so bead saves from the UI never wait on the parse. The UI thread
+// shows the progress fields and joins the thread once done is set.
+typedef struct {
+    pthread_t thread;
+    bool running;                 // Started and not yet joined (UI thread only)
+    BeadCatalog* catalog;
+    char* path;
+    uint64_t bytes_read;          // Progress, stored atomically by the import thread
+    uint64_t total_bytes;
+    uint64_t rows;
+    bool done;
+    bool succeeded;
+    BeadImportProgress progress;  // Final counts, valid once done
+} FeedImport;
+
+static FeedImport feed_import = {0};
+
+static void record_import_progress(const BeadImportProgress* progress, void* user_data) {
+    FeedImport* import = user_data;
+    __atomic_store_n(&import->bytes_read, progress->bytes_read, __ATOMIC_RELAXED);
+    __atomic_store_n(&import->total_bytes, progress->total_bytes, __ATOMIC_RELAXED);
+    __atomic_store_n(&import->rows, progress->rows, __ATOMIC_RELAXED);
+    print_import_progress(progress, NULL);
+}
+
+// Add every imported bead to the next catalog version, in slot order so the
+// first row with a given id still wins
+static bool merge_imported_beads(BeadCollection* next, BeadCollection* imported) {
+    uint32_t slot = 0;
+    while (slot < imported->count) {
+        // Slots are contiguous within a segment, so add a segment at a time
+        const BeadDefinition* first = get_bead_at(imported, slot);
+        uint32_t run = 1;
+        while (slot + run < imported->count && get_bead_at(imported, slot + run) == first + run) run++;
+        if (add_bead_definitions(next, first, run) != run) return false;
+        slot += run;
+    }
+    return true;
+}
+
+static void* run_feed_import(void* arg) {
+    FeedImport* import = arg;
+    bool succeeded = false;
+    BeadCollection* imported = create_bead_collection();
+    if (imported) {
+        BeadImportOptions options = make_bead_import_options();
+        options.on_progress = record_import_progress;
+        options.user_data = import;
+        succeeded = import_bead_feed(imported, import->path, &options, &import->progress);
+    }
+
+    // Hold the catalog's writer lock only for the merge, and publish only if
+    // the whole feed loaded
+    BeadCollection* next = succeeded ? begin_bead_catalog_update(import->catalog) : NULL;
+    succeeded = next && merge_imported_beads(next, imported);
+    if (succeeded) {
+        publish_bead_catalog_update(import->catalog, next);
+    } else if (next) {
+        discard_bead_catalog_update(import->catalog, next);
+    }
+    free_bead_collection(imported);
+    import->succeeded = succeeded;
+    __atomic_store_n(&import->done, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Start importing a feed in the background; false if one is already running
+static bool start_feed_import(BeadCatalog* catalog, const char* path) {
+    if (feed_import.running) return false;
+    char* path_copy = strdup(path);
+    if (!path_copy) return false;
+
+    feed_import = (FeedImport){ .catalog = catalog, .path = path_copy };
+    if (pthread_create(&feed_import.thread, NULL, run_feed_import, &feed_import) != 0) {
+        free(path_copy);
+        feed_import.path = NULL;
+        return false;
+    }
+    feed_import.running = true;
+    return true;
+}
+
+// Join the import thread once it has finished and report the result. With
+// wait set, block until it finishes.
+static void finish_feed_import(bool wait) {
+    if (!feed_import.running) return;
+    if (!wait && !__atomic_load_n(&feed_import.done, __ATOMIC_ACQUIRE)) return;
+
+    pthread_join(feed_import.thread, NULL);
+    feed_import.running = false;
+    if (!feed_import.succeeded) {
+        printf("Failed to import bead feed %s\n", feed_import.path);
+    }
+    printf("Imported %llu of %llu rows from %s\n", (unsigned long long)feed_import.progress.imported,
+           (unsigned long long)feed_import.progress.rows, feed_import.path);
+    free(feed_import.path);
+    feed_import.path = NULL;
+}
+
+// Number of beads in the palette, and the bead shown at a palette position
+static uint32_t get_palette_count(BeadCollection* beads) {
+    return search_text_buffer[0] ? search_result_count : beads->count;
+}
+
+static BeadDefinition* get_palette_bead(BeadCollection* beads, uint32_t index) {
+    return search_text_buffer[0] ? search_results[index].bead : get_bead_at(beads, index);
+}
+
+// Put the top search results into the circle menu, skipping beads already there
+static void add_search_results_to_menu(BraceletDoc* doc) {
+    uint32_t added = 0;
+    for (uint32_t i = 0; i < search_result_count && added < MAX_SEARCH_MENU_BEADS; i++) {
+        BeadDefinition* bead = search_results[i].bead;
+        bool present = false;
+        for (size_t j = 0; j < circle_menu_get_count(doc->menu) && !present; j++) {
+            const char* bead_id = circle_menu_get_bead_id(doc->menu, j);
+            present = bead_id && strcmp(bead_id, bead->id) == 0;
+        }
+        if (present) continue;
+
+        circle_menu_add_circle(doc->menu, 0, 0, doc->bead_radius_px, bead->name);
+        size_t new_circle_index = circle_menu_get_count(doc->menu) - 1;
+        circle_menu_update_bead(doc->menu, new_circle_index, bead->name, bead->id);
+        added++;
+    }
+    if (added > 0) doc->circle_menu_visible = true;
+}
+
+// Feed typed characters into the search box while it has focus
+static void update_search_box(BraceletDoc* doc) {
+    if (!search_box_active) return;
+
+    size_t length = strlen(search_text_buffer);
+    int key = GetCharPressed();
+    while (key > 0) {
+        if (key >= 32 && key < 127 && length + 1 < sizeof(search_text_buffer)) {
+            search_text_buffer[length++] = (char)key;
+            search_text_buffer[length] = '\0';
+            search_dirty = true;
+        }
+        key = GetCharPressed();
+    }
+    if (IsKeyPressed(KEY_BACKSPACE) && length > 0) {
+        search_text_buffer[length - 1] = '\0';
+        search_dirty = true;
+    }
+    if (IsKeyPressed(KEY_ENTER)) {
+        add_search_results_to_menu(doc);
+        search_box_active = false;
+    }
+}
+
 uint32_t load_bead_image(const char* path) {
     if (num_bead_images >= MAX_BEAD_IMAGES) return 0;
     
@@ -210,9 +413,19 @@ int main(void) {
 
     Clay_SetMeasureTextFunction(Clay_Raylib_MeasureText);
 
-    // Initialize bead collection
-    BeadCollection* beads = create_bead_collection();
-    initialize_sample_beads(beads);
+    // Initialize bead collection from the binary catalog if there is one,
+    // otherwise from the samples. Each frame reads a pinned snapshot of the
+    // local store; bead pointers and strings outlive the snapshot.
+    bool have_catalog = surreal_load_catalog(BEAD_CATALOG_PATH);
+    BeadCatalog* catalog = surreal_get_catalog();
+    if (!have_catalog) {
+        BeadCollection* next = begin_bead_catalog_update(catalog);
+        if (next) {
+            initialize_sample_beads(next);
+            publish_bead_catalog_update(catalog, next);
+        }
+    }
+    BeadCollection* beads = acquire_bead_snapshot(catalog);
 
     // Initialize bracelet with 8mm beads and 24 slots
     BraceletConfig config = {
@@ -229,10 +442,15 @@ int main(void) {
             .start_index = 0
         }
     };
-    initialize_bracelet(&clayMemory, config);
+    BraceletWorkspace* workspace = create_bracelet_workspace();
+    BraceletDoc* doc = open_bracelet_doc(workspace, config);
+    if (!doc) {
+        fprintf(stderr, "Failed to create bracelet document\n");
+        return 1;
+    }
 
     // Track current bead selection - start with the first bead selected
-    const char* selected_bead_id = beads->count > 0 ? beads->definitions[0].id : NULL;
+    const char* selected_bead_id = beads->count > 0 ? get_bead_at(beads, 0)->id : NULL;
 
     // After loading initial bead images
     BeadDefinition starter_beads[] = {
@@ -270,22 +488,27 @@ int main(void) {
         printf("Adding starter bead %zu: %s\n", i, starter_beads[i].name);
         if (surreal_save_bead(&starter_beads[i])) {
             // Add to circle menu
-            circle_menu_add_circle(bracelet_state.menu, 0, 0, 
-                                 bracelet_state.bead_radius_px, starter_beads[i].name);
-            size_t new_circle_index = circle_menu_get_count(bracelet_state.menu) - 1;
-            circle_menu_update_bead(bracelet_state.menu, new_circle_index, 
+            circle_menu_add_circle(doc->menu, 0, 0, 
+                                 doc->bead_radius_px, starter_beads[i].name);
+            size_t new_circle_index = circle_menu_get_count(doc->menu) - 1;
+            circle_menu_update_bead(doc->menu, new_circle_index, 
                                    starter_beads[i].name, starter_beads[i].id);
             printf("Added starter bead to circle menu at index %zu\n", new_circle_index);
         }
     }
 
+    release_bead_snapshot(catalog, beads);
+
     while (!WindowShouldClose()) {
+        finish_feed_import(false);
+        beads = acquire_bead_snapshot(catalog);
+
         // Update
         Vector2 mousePos = GetMousePosition();
         Clay_Vector2 clayMousePos = { mousePos.x, mousePos.y };
         
         // Handle circle menu clicks
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && bracelet_state.circle_menu_visible) {
+        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && doc->circle_menu_visible) {
             // Check if click is in circle menu area
             int panel_width = 200;
             int panel_x = GetScreenWidth() - panel_width;
@@ -302,8 +525,8 @@ int main(void) {
                 
                 if (col >= 0 && col < circles_per_row) {
                     size_t index = row * circles_per_row + col;
-                    if (index < circle_menu_get_count(bracelet_state.menu)) {
-                        const char* bead_id = circle_menu_get_bead_id(bracelet_state.menu, index);
+                    if (index < circle_menu_get_count(doc->menu)) {
+                        const char* bead_id = circle_menu_get_bead_id(doc->menu, index);
                         if (bead_id) {
                             BeadDefinition* bead = find_bead_by_id(beads, bead_id);
                             if (bead) {
@@ -332,14 +555,19 @@ int main(void) {
         });
 
         // Update bracelet state
-        update_hovered_bead(clayMousePos);
+        update_hovered_bead(doc, clayMousePos);
+
+        // Search box typing; keys go to the box rather than the shortcuts below
+        bool search_typing = search_box_active;
+        update_search_box(doc);
+        refresh_bead_search(beads);
 
         // Handle bead selection with arrow keys
-        if (IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_LEFT)) {
+        if (!search_typing && (IsKeyPressed(KEY_RIGHT) || IsKeyPressed(KEY_LEFT))) {
             int current_bead = 0;
             // Find current bead index
             for (size_t i = 0; i < beads->count; i++) {
-                if (strcmp(beads->definitions[i].id, selected_bead_id) == 0) {
+                if (strcmp(get_bead_at(beads, i)->id, selected_bead_id) == 0) {
                     current_bead = i;
                     break;
                 }
@@ -350,24 +578,25 @@ int main(void) {
             } else {
                 current_bead = (current_bead - 1 + beads->count) % beads->count;
             }
-            selected_bead_id = beads->definitions[current_bead].id;
+            selected_bead_id = get_bead_at(beads, current_bead)->id;
         }
 
         // Handle bead placement with mouse or space
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || IsKeyPressed(KEY_SPACE)) {
+        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) || (!search_typing && IsKeyPressed(KEY_SPACE))) {
             printf("Input detected - Mouse: %d, Space: %d\n", 
                    IsMouseButtonPressed(MOUSE_LEFT_BUTTON), IsKeyPressed(KEY_SPACE));
             
-            int32_t hovered_index = find_hovered_bead(clayMousePos);
+            // Hit tested against this frame's pointer by update_hovered_bead above
+            int32_t hovered_index = doc->hovered_index;
             printf("Hover check - index: %d\n", hovered_index);
 
             // First check if we clicked a bead button
             bool clicked_button = false;
-            for (size_t i = 0; i < beads->count; i++) {
+            for (size_t i = 0; i < get_palette_count(beads); i++) {
                 snprintf(button_id_buffer, MAX_BUTTON_ID_LENGTH, "BeadButton_%zu", i);
                 Clay_ElementId elementId = Clay_GetElementId(CLAY_STRING(button_id_buffer));
                 if (Clay_PointerOver(elementId)) {
-                    selected_bead_id = beads->definitions[i].id;
+                    selected_bead_id = get_palette_bead(beads, i)->id;
                     clicked_button = true;
                     printf("Selected bead: %s\n", selected_bead_id);
                     break;
@@ -378,29 +607,16 @@ int main(void) {
             if (!clicked_button && hovered_index >= 0 && selected_bead_id) {
                 BeadDefinition* bead = find_bead_by_id(beads, selected_bead_id);
                 if (bead) {
-                    // Get all selected slots based on current pattern
-                    int32_t selected_indices[24];  // Max number of beads
-                    int selected_count = 0;
-                    get_selected_indices(hovered_index, selected_indices, &selected_count);
-
-                    // Place bead in all selected slots
-                    printf("Placing bead %s in %d slots\n", bead->id, selected_count);
-                    for (int i = 0; i < selected_count; i++) {
-                        place_bead(
-                            selected_indices[i],
-                            bead->color,
-                            bead->image_id,
-                            bead->id
-                        );
-                    }
+                    // Fill all selected slots based on current pattern
+                    place_beads_by_pattern(doc, hovered_index, get_bead_handle(beads, bead));
                 }
             }
         }
 
         // Add keyboard navigation
-        if (bracelet_state.circle_menu_visible) {
+        if (doc->circle_menu_visible) {
             static int selected_index = 0;
-            size_t menu_count = circle_menu_get_count(bracelet_state.menu);
+            size_t menu_count = circle_menu_get_count(doc->menu);
             
             if (IsKeyPressed(KEY_RIGHT)) {
                 selected_index = (selected_index + 1) % menu_count;
@@ -414,8 +630,8 @@ int main(void) {
             if (IsKeyPressed(KEY_DOWN)) {
                 selected_index = (selected_index + 3) % menu_count;
             }
-            if (IsKeyPressed(KEY_ENTER) && menu_count > 0) {
-                const char* bead_id = circle_menu_get_bead_id(bracelet_state.menu, selected_index);
+            if (!search_typing && IsKeyPressed(KEY_ENTER) && menu_count > 0) {
+                const char* bead_id = circle_menu_get_bead_id(doc->menu, selected_index);
                 if (bead_id) {
                     BeadDefinition* bead = find_bead_by_id(beads, bead_id);
                     if (bead) {
@@ -480,6 +696,34 @@ int main(void) {
                     CLAY_TEXT(title, &TITLE_TEXT_CONFIG);
                 }
 
+                // Search box; Enter sends the top results to the circle menu
+                CLAY(
+                    CLAY_ID("SearchBox"),
+                    CLAY_LAYOUT({
+                        .sizing = { CLAY_SIZING_GROW(), CLAY_SIZING_FIXED(30) },
+                        .padding = { 5, 5 },
+                        .childAlignment = { .y = CLAY_ALIGN_Y_CENTER }
+                    }),
+                    CLAY_RECTANGLE({
+                        .color = search_box_active ?
+                            (Clay_Color){.r = 0.3f, .g = 0.3f, .b = 0.35f, .a = 1.0f} :
+                            (Clay_Color){.r = 0.25f, .g = 0.25f, .b = 0.28f, .a = 1.0f},
+                        .cornerRadius = {.topLeft = 3, .topRight = 3, .bottomLeft = 3, .bottomRight = 3}
+                    })
+                ) {
+                    if (search_text_buffer[0]) {
+                        Clay_String query = { .length = (int)strlen(search_text_buffer), .chars = search_text_buffer };
+                        CLAY_TEXT(query, &DEFAULT_TEXT_CONFIG);
+                    } else {
+                        CLAY_TEXT(CLAY_STRING("Search beads..."), &DEFAULT_TEXT_CONFIG);
+                    }
+
+                    // Clicking the box focuses it, clicking anywhere else releases it
+                    if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+                        search_box_active = Clay_PointerOver(Clay_GetElementId(CLAY_STRING("SearchBox")));
+                    }
+                }
+
                 // Pattern controls section
                 CLAY(
                     CLAY_LAYOUT({
@@ -506,20 +750,20 @@ int main(void) {
                             "All"
                         };
                         
-                        CLAY_TEXT(CLAY_STRING(pattern_names[bracelet_state.config.selection.pattern]), &DEFAULT_TEXT_CONFIG);
+                        CLAY_TEXT(CLAY_STRING(pattern_names[doc->config.selection.pattern]), &DEFAULT_TEXT_CONFIG);
 
                         // Handle click to cycle pattern
                         if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("PatternButton"))) && 
                             IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                            BraceletConfig config = get_bracelet_config();
+                            BraceletConfig config = get_bracelet_config(doc);
                             config.selection.pattern = (config.selection.pattern + 1) % PATTERN_MAX;
-                            update_bracelet_config(config);
+                            update_bracelet_config(doc, config);
                         }
                     }
 
                     // Show size controls for Group and Alternate patterns
-                    if (bracelet_state.config.selection.pattern == PATTERN_GROUP || 
-                        bracelet_state.config.selection.pattern == PATTERN_ALTERNATE) {
+                    if (doc->config.selection.pattern == PATTERN_GROUP || 
+                        doc->config.selection.pattern == PATTERN_ALTERNATE) {
                         
                         // Group size controls
                         CLAY(
@@ -547,10 +791,10 @@ int main(void) {
                                 
                                 if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("DecGroupSize"))) && 
                                     IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                                    BraceletConfig config = get_bracelet_config();
+                                    BraceletConfig config = get_bracelet_config(doc);
                                     if (config.selection.group_size > 1) {
                                         config.selection.group_size--;
-                                        update_bracelet_config(config);
+                                        update_bracelet_config(doc, config);
                                         snprintf(group_text_buffer, sizeof(group_text_buffer), "%d", config.selection.group_size);
                                     }
                                 }
@@ -574,16 +818,16 @@ int main(void) {
                                 
                                 if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("IncGroupSize"))) && 
                                     IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                                    BraceletConfig config = get_bracelet_config();
+                                    BraceletConfig config = get_bracelet_config(doc);
                                     config.selection.group_size++;
-                                    update_bracelet_config(config);
+                                    update_bracelet_config(doc, config);
                                     snprintf(group_text_buffer, sizeof(group_text_buffer), "%d", config.selection.group_size);
                                 }
                             }
                         }
 
                         // Skip controls (only for Alternate pattern)
-                        if (bracelet_state.config.selection.pattern == PATTERN_ALTERNATE) {
+                        if (doc->config.selection.pattern == PATTERN_ALTERNATE) {
                             CLAY(
                                 CLAY_LAYOUT({
                                     .sizing = { CLAY_SIZING_GROW(), CLAY_SIZING_FIXED(40) },
@@ -609,10 +853,10 @@ int main(void) {
                                     
                                     if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("DecSkipSize"))) && 
                                         IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                                        BraceletConfig config = get_bracelet_config();
+                                        BraceletConfig config = get_bracelet_config(doc);
                                         if (config.selection.skip_size > 0) {
                                             config.selection.skip_size--;
-                                            update_bracelet_config(config);
+                                            update_bracelet_config(doc, config);
                                             snprintf(skip_text_buffer, sizeof(skip_text_buffer), "%d", config.selection.skip_size);
                                         }
                                     }
@@ -636,9 +880,9 @@ int main(void) {
                                     
                                     if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("IncSkipSize"))) && 
                                         IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                                        BraceletConfig config = get_bracelet_config();
+                                        BraceletConfig config = get_bracelet_config(doc);
                                         config.selection.skip_size++;
-                                        update_bracelet_config(config);
+                                        update_bracelet_config(doc, config);
                                         snprintf(skip_text_buffer, sizeof(skip_text_buffer), "%d", config.selection.skip_size);
                                     }
                                 }
@@ -670,8 +914,8 @@ int main(void) {
                         })
                     ) {
                         // Bead selection buttons
-                        for (size_t i = 0; i < beads->count; i++) {
-                            BeadDefinition* bead = &beads->definitions[i];
+                        for (size_t i = 0; i < get_palette_count(beads); i++) {
+                            BeadDefinition* bead = get_palette_bead(beads, i);
                             bool is_selected = (selected_bead_id && strcmp(selected_bead_id, bead->id) == 0);
                             
                             // Generate button ID
@@ -786,7 +1030,7 @@ int main(void) {
                     .sizing = { CLAY_SIZING_GROW(), CLAY_SIZING_GROW() }
                 })
             ) {
-                render_bracelet(beads);
+                render_bracelet(doc, beads);
 
                 // Circle menu button
                 CLAY(
@@ -813,7 +1057,7 @@ int main(void) {
                     // Handle click
                     Clay_ElementId button_id = Clay_GetElementId(CLAY_STRING("CircleMenuButton"));
                     if (Clay_PointerOver(button_id) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                        bracelet_toggle_circle_menu();
+                        bracelet_toggle_circle_menu(doc);
                     }
                 }  // End CircleMenuButton
             }  // End MainArea
@@ -854,17 +1098,17 @@ int main(void) {
                         
                         if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("DecBeadCount"))) && 
                             IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                            BraceletConfig config = get_bracelet_config();
+                            BraceletConfig config = get_bracelet_config(doc);
                             if (config.bead_count > 12) {  // Minimum 12 beads
                                 config.bead_count--;
-                                update_bracelet_config(config);
+                                update_bracelet_config(doc, config);
                             }
                         }
                     }
                     
                     // Show current value
                     char bead_count_text[8];
-                    snprintf(bead_count_text, sizeof(bead_count_text), "%d", bracelet_state.config.bead_count);
+                    snprintf(bead_count_text, sizeof(bead_count_text), "%d", doc->config.bead_count);
                     CLAY_TEXT(CLAY_STRING(bead_count_text), &DEFAULT_TEXT_CONFIG);
                     
                     // Increase button
@@ -882,10 +1126,10 @@ int main(void) {
                         
                         if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("IncBeadCount"))) && 
                             IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                            BraceletConfig config = get_bracelet_config();
+                            BraceletConfig config = get_bracelet_config(doc);
                             if (config.bead_count < 48) {  // Maximum 48 beads
                                 config.bead_count++;
-                                update_bracelet_config(config);
+                                update_bracelet_config(doc, config);
                             }
                         }
                     }
@@ -916,7 +1160,7 @@ int main(void) {
                     
                     if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("SettingsButton"))) && 
                         IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                        bracelet_state.settings_dialog_open = !bracelet_state.settings_dialog_open;
+                        doc->settings_dialog_open = !doc->settings_dialog_open;
                     }
                 }
                 
@@ -935,11 +1179,11 @@ int main(void) {
                     
                     if (Clay_PointerOver(Clay_GetElementId(CLAY_STRING("QuickSaveButton"))) && 
                         IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-                        if (bracelet_state.current_file[0]) {
-                            save_bracelet_to_file(bracelet_state.current_file);
-                            bracelet_state.has_unsaved_changes = false;
+                        if (doc->current_file[0]) {
+                            save_bracelet_to_file(doc, doc->current_file, beads);
+                            doc->has_unsaved_changes = false;
                         } else {
-                            bracelet_state.settings_dialog_open = true;  // Open settings to save
+                            doc->settings_dialog_open = true;  // Open settings to save
                         }
                     }
                 }
@@ -952,7 +1196,7 @@ int main(void) {
         ClearBackground(BLACK);
         
         Clay_Raylib_Render(commands);
-        render_bracelet(beads);
+        render_bracelet(doc, beads);
 
         // Handle dragging (should be on top of bracelet)
         if (drag_state.is_dragging) {
@@ -972,34 +1216,11 @@ int main(void) {
 
             // Handle drop
             if (IsMouseButtonReleased(MOUSE_LEFT_BUTTON)) {
-                int32_t hovered_index = find_hovered_bead(drag_state.current_pos);
+                int32_t hovered_index = find_hovered_bead(doc, drag_state.current_pos);
                 if (hovered_index >= 0) {
                     BeadDefinition* bead = find_bead_by_id(beads, drag_state.dragged_bead_id);
                     if (bead) {
-                        BraceletConfig current_config = get_bracelet_config();
-                        
-                        if (current_config.selection.pattern == PATTERN_ALTERNATE) {
-                            int total_pattern = current_config.selection.group_size + current_config.selection.skip_size;
-                            
-                            // Place beads in alternating pattern around the bracelet
-                            for (int pos = hovered_index; pos < hovered_index + bracelet_state.num_slots; pos += total_pattern) {
-                                // Place the group at this position
-                                for (int i = 0; i < current_config.selection.group_size && 
-                                     (pos + i) < hovered_index + bracelet_state.num_slots; i++) {
-                                    int idx = (pos + i) % bracelet_state.num_slots;
-                                    place_bead(idx, bead->color, bead->image_id, bead->id);
-                                }
-                            }
-                        } else {
-                            // For other patterns, use get_selected_indices
-                            int32_t selected_indices[24];
-                        int selected_count = 0;
-                        get_selected_indices(hovered_index, selected_indices, &selected_count);
-
-                        for (int i = 0; i < selected_count; i++) {
-                                place_bead(selected_indices[i], bead->color, bead->image_id, bead->id);
-                            }
-                        }
+                        place_beads_by_pattern(doc, hovered_index, get_bead_handle(beads, bead));
                     }
                 }
                 drag_state.is_dragging = false;
@@ -1069,32 +1290,24 @@ int main(void) {
                         
                         printf("Saving new bead...\n");
                         if (surreal_save_bead(&new_bead)) {
-                            // Get updated collection
-                            BeadCollection* updated_beads = surreal_get_all_beads();
-                            if (updated_beads) {
-                                printf("Got updated beads collection with %d beads\n", updated_beads->count);
-                                free_bead_collection(beads);
-                                beads = updated_beads;
-                                
-                                // Add to circle menu - get count before adding
-                                size_t menu_count_before = circle_menu_get_count(bracelet_state.menu);
-                                
-                                // Add new circle
-                                circle_menu_add_circle(bracelet_state.menu, 0, 0, 
-                                                     bracelet_state.bead_radius_px, new_bead.name);
-                                
-                                size_t menu_count_after = circle_menu_get_count(bracelet_state.menu);
-                                printf("Circle menu count before: %zu, after: %zu\n", 
-                                       menu_count_before, menu_count_after);
-                                
-                                // Update the newly added circle
-                                size_t new_circle_index = menu_count_after - 1;
-                                circle_menu_update_bead(bracelet_state.menu, new_circle_index, 
-                                                      new_bead.name, new_bead.id);
-                                
-                                printf("Added new bead to circle menu at index %zu: %s (id: %s)\n", 
-                                       new_circle_index, new_bead.name, new_bead.id);
-                            }
+                            // Add to circle menu - get count before adding
+                            size_t menu_count_before = circle_menu_get_count(doc->menu);
+                            
+                            // Add new circle
+                            circle_menu_add_circle(doc->menu, 0, 0, 
+                                                 doc->bead_radius_px, new_bead.name);
+                            
+                            size_t menu_count_after = circle_menu_get_count(doc->menu);
+                            printf("Circle menu count before: %zu, after: %zu\n", 
+                                   menu_count_before, menu_count_after);
+                            
+                            // Update the newly added circle
+                            size_t new_circle_index = menu_count_after - 1;
+                            circle_menu_update_bead(doc->menu, new_circle_index, 
+                                                  new_bead.name, new_bead.id);
+                            
+                            printf("Added new bead to circle menu at index %zu: %s (id: %s)\n", 
+                                   new_circle_index, new_bead.name, new_bead.id);
                         }
                         
                         // Clean up temporary bead
@@ -1197,17 +1410,11 @@ int main(void) {
                 };
                 
                 if (surreal_save_bead(&new_bead)) {
-                    BeadCollection* updated_beads = surreal_get_all_beads();
-                    if (updated_beads) {
-                        free_bead_collection(beads);
-                        beads = updated_beads;
-                        
-                        // Update circle menu
-                        if (circle_info_dialog.is_editing) {
-                            circle_menu_update_bead(bracelet_state.menu, 
-                                                 circle_info_dialog.editing_index,
-                                                 new_bead.name, new_bead.id);
-                        }
+                    // Update circle menu
+                    if (circle_info_dialog.is_editing) {
+                        circle_menu_update_bead(doc->menu, 
+                                             circle_info_dialog.editing_index,
+                                             new_bead.name, new_bead.id);
                     }
                 }
                 circle_info_dialog.is_open = false;
@@ -1223,16 +1430,16 @@ int main(void) {
             if (GuiButton((Rectangle){dialog_x + dialog_width - 200, dialog_y + dialog_height - 40, 
                                      180, 30}, "Add to Selection Menu")) {
                 // Add to selection menu
-                circle_menu_add_circle(bracelet_state.menu, 0, 0, 
-                                     bracelet_state.bead_radius_px, circle_info_dialog.name);
-                size_t new_circle_index = circle_menu_get_count(bracelet_state.menu) - 1;
-                circle_menu_update_bead(bracelet_state.menu, new_circle_index, 
+                circle_menu_add_circle(doc->menu, 0, 0, 
+                                     doc->bead_radius_px, circle_info_dialog.name);
+                size_t new_circle_index = circle_menu_get_count(doc->menu) - 1;
+                circle_menu_update_bead(doc->menu, new_circle_index, 
                                        circle_info_dialog.name, circle_info_dialog.selected_bead->id);
             }
         }
 
         // In the circle menu rendering section:
-        if (bracelet_state.circle_menu_visible) {
+        if (doc->circle_menu_visible) {
             // Define panel dimensions
             int panel_width = 200;
             int panel_height = GetScreenHeight();
@@ -1246,7 +1453,7 @@ int main(void) {
                               (Color){180, 180, 180, 255});
             
             // Draw circles in grid layout
-            size_t count = circle_menu_get_count(bracelet_state.menu);
+            size_t count = circle_menu_get_count(doc->menu);
             int circles_per_row = 3;
             int circle_spacing = 20;
             int circle_size = (panel_width - (circles_per_row + 1) * circle_spacing) / circles_per_row;
@@ -1265,7 +1472,7 @@ int main(void) {
                           (Color){200, 200, 200, 255});
                 
                 // Draw bead image if available
-                const char* bead_id = circle_menu_get_bead_id(bracelet_state.menu, i);
+                const char* bead_id = circle_menu_get_bead_id(doc->menu, i);
                 if (bead_id) {
                     BeadDefinition* bead = find_bead_by_id(beads, bead_id);
                     if (bead && bead->image_id > 0 && bead->image_id <= num_bead_images) {
@@ -1282,7 +1489,7 @@ int main(void) {
                 }
                 
                 // Draw selection highlight if needed
-                if (circle_menu_is_selected(bracelet_state.menu, i)) {
+                if (circle_menu_is_selected(doc->menu, i)) {
                     DrawCircleLines(x + circle_size/2, y + circle_size/2, circle_size/2, BLUE);
                     DrawCircleLines(x + circle_size/2, y + circle_size/2, circle_size/2 + 2, SKYBLUE);
                 }
@@ -1290,7 +1497,7 @@ int main(void) {
         }
 
         // Add settings dialog rendering:
-        if (bracelet_state.settings_dialog_open) {
+        if (doc->settings_dialog_open) {
             int dialog_width = 400;
             int dialog_height = 500;
             int dialog_x = GetScreenWidth()/2 - dialog_width/2;
@@ -1312,31 +1519,72 @@ int main(void) {
             // Bead count control
             GuiLabel((Rectangle){dialog_x + padding, y, 80, 30}, "Beads:");
             if (GuiSpinner((Rectangle){dialog_x + padding + 90, y, 100, 30},
-                           NULL, &bracelet_state.config.bead_count, 12, 48, true)) {
-                update_bracelet_config(bracelet_state.config);
+                           NULL, &doc->config.bead_count, 12, 48, true)) {
+                update_bracelet_config(doc, doc->config);
             }
             y += 40;
             
             // Knot toggle
             if (GuiButton((Rectangle){dialog_x + padding, y, 150, 30},
-                          bracelet_state.config.has_knot ? "Knot: On" : "Knot: Off")) {
-                BraceletConfig config = get_bracelet_config();
+                          doc->config.has_knot ? "Knot: On" : "Knot: Off")) {
+                BraceletConfig config = get_bracelet_config(doc);
                 config.has_knot = !config.has_knot;
-                update_bracelet_config(config);
+                update_bracelet_config(doc, config);
             }
             y += 40;
             
             // Cord ends toggle (only show if knot is enabled)
-            if (bracelet_state.config.has_knot) {
+            if (doc->config.has_knot) {
                 if (GuiButton((Rectangle){dialog_x + padding, y, 150, 30},
-                              bracelet_state.config.has_cord_ends ? "Cord Ends: On" : "Cord Ends: Off")) {
-                    BraceletConfig config = get_bracelet_config();
+                              doc->config.has_cord_ends ? "Cord Ends: On" : "Cord Ends: Off")) {
+                    BraceletConfig config = get_bracelet_config(doc);
                     config.has_cord_ends = !config.has_cord_ends;
-                    update_bracelet_config(config);
+                    update_bracelet_config(doc, config);
                 }
                 y += 40;
             }
             
+            // Bulk-load a supplier feed into the bead collection
+            y = dialog_y + dialog_height - 160;
+            if (feed_import.running) {
+                // The catalog picks up the feed when the import thread publishes it
+                uint64_t total_bytes = __atomic_load_n(&feed_import.total_bytes, __ATOMIC_RELAXED);
+                uint64_t bytes_read = __atomic_load_n(&feed_import.bytes_read, __ATOMIC_RELAXED);
+                uint64_t rows = __atomic_load_n(&feed_import.rows, __ATOMIC_RELAXED);
+                char import_text[64];
+                snprintf(import_text, sizeof(import_text), "Importing feed: %d%% (%llu rows)",
+                         total_bytes ? (int)(bytes_read * 100 / total_bytes) : 0, (unsigned long long)rows);
+                GuiLabel((Rectangle){dialog_x + padding, y, dialog_width - padding*2, 30}, import_text);
+            } else if (GuiButton((Rectangle){dialog_x + padding, y, 210, 30}, "Import Supplier Feed")) {
+                const char* filters[] = { "*.csv", "*.ndjson", "*.jsonl" };
+                const char* file = tinyfd_openFileDialog(
+                    "Import Supplier Feed",
+                    "",
+                    3,
+                    filters,
+                    "Bead Feeds",
+                    0
+                );
+                if (file && !start_feed_import(catalog, file)) {
+                    printf("Failed to start importing bead feed %s\n", file);
+                }
+            }
+
+            // Export the bead catalog for fast loading on the next start
+            y = dialog_y + dialog_height - 120;
+            if (GuiButton((Rectangle){dialog_x + padding, y, 210, 30}, "Export Bead Catalog")) {
+                const char* file = tinyfd_saveFileDialog(
+                    "Export Bead Catalog",
+                    BEAD_CATALOG_PATH,
+                    0,
+                    NULL,
+                    "Bead Catalogs"
+                );
+                if (file && !save_bead_catalog(beads, file)) {
+                    printf("Failed to export bead catalog to %s\n", file);
+                }
+            }
+
             // Save/Load buttons
             y = dialog_y + dialog_height - 80;
             
@@ -1350,9 +1598,9 @@ int main(void) {
                 );
                 if (file) {
                     // TODO: Implement save_bracelet_to_file
-                    save_bracelet_to_file(file);
-                    strncpy(bracelet_state.current_file, file, sizeof(bracelet_state.current_file) - 1);
-                    bracelet_state.has_unsaved_changes = false;
+                    save_bracelet_to_file(doc, file, beads);
+                    strncpy(doc->current_file, file, sizeof(doc->current_file) - 1);
+                    doc->has_unsaved_changes = false;
                 }
             }
             
@@ -1367,24 +1615,28 @@ int main(void) {
                 );
                 if (file) {
                     // TODO: Implement load_bracelet_from_file
-                    load_bracelet_from_file(file);
-                    strncpy(bracelet_state.current_file, file, sizeof(bracelet_state.current_file) - 1);
+                    load_bracelet_from_file(doc, file);
+                    strncpy(doc->current_file, file, sizeof(doc->current_file) - 1);
                 }
             }
             
             // Close button
             if (GuiButton((Rectangle){dialog_x + dialog_width - 90, y, 80, 30}, "Close")) {
-                bracelet_state.settings_dialog_open = false;
+                doc->settings_dialog_open = false;
             }
         }
 
         EndDrawing();
+
+        release_bead_snapshot(catalog, beads);
+        reclaim_bead_snapshots(catalog);
     }  // End while loop
 
     // Cleanup section
-    free_bead_collection(beads);
+    finish_feed_import(true);
+    surreal_cleanup();
     unload_bead_images();
-    cleanup_bracelet();
+    free_bracelet_workspace(workspace);
     free(clayMemory.memory);
     CloseWindow();
 
@@ -0,0 +1,172 @@
+#include "string_arena.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STRING_ARENA_FIRST_BLOCK (16 * 1024)
+#define STRING_ARENA_MAX_BLOCK (1024 * 1024)
+
+struct StringArenaBlock {
+    StringArenaBlock* next;
+    size_t size;
+    char data[];
+};
+
+uint32_t hash_string(const char* str) {
+    uint32_t hash = 2166136261u;
+    while (*str) {
+        hash ^= (uint8_t)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+StringArena* string_arena_create(void) {
+    StringArena* arena = calloc(1, sizeof(StringArena));
+    if (!arena) return NULL;
+
+    arena->table_capacity = 256;
+    arena->table = calloc(arena->table_capacity, sizeof(StringArenaEntry));
+    if (!arena->table) {
+        free(arena);
+        return NULL;
+    }
+    arena->next_block_size = STRING_ARENA_FIRST_BLOCK;
+    return arena;
+}
+
+// Copy bytes into the newest block, starting a new block when it is full
+static char* arena_copy(StringArena* arena, const char* str, size_t length) {
+    if (length + 1 > arena->remaining) {
+        size_t size = arena->next_block_size;
+        if (size < length + 1) size = length + 1;
+
+        StringArenaBlock* block = malloc(sizeof(StringArenaBlock) + size);
+        if (!block) return NULL;
+        block->next = arena->blocks;
+        block->size = size;
+        arena->blocks = block;
+        arena->cursor = block->data;
+        arena->remaining = size;
+        arena->bytes_reserved += size;
+
+        if (arena->next_block_size < STRING_ARENA_MAX_BLOCK) {
+            arena->next_block_size *= 2;
+        }
+    }
+
+    char* copy = arena->cursor;
+    memcpy(copy, str, length + 1);
+    arena->cursor += length + 1;
+    arena->remaining -= length + 1;
+    return copy;
+}
+
+static uint32_t table_probe(StringArena* arena, const char* str, uint32_t hash) {
+    uint32_t mask = arena->table_capacity - 1;
+    uint32_t pos = hash & mask;
+    while (arena->table[pos].str) {
+        if (arena->table[pos].hash == hash && strcmp(arena->table[pos].str, str) == 0) {
+            break;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+static bool table_grow(StringArena* arena) {
+    uint32_t new_capacity = arena->table_capacity * 2;
+    StringArenaEntry* new_table = calloc(new_capacity, sizeof(StringArenaEntry));
+    if (!new_table) return false;
+
+    StringArenaEntry* old_table = arena->table;
+    uint32_t old_capacity = arena->table_capacity;
+    arena->table = new_table;
+    arena->table_capacity = new_capacity;
+
+    // Stored hashes let entries move without rehashing their strings
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old_table[i].str) {
+            uint32_t pos = old_table[i].hash & (new_capacity - 1);
+            while (new_table[pos].str) {
+                pos = (pos + 1) & (new_capacity - 1);
+            }
+            new_table[pos] = old_table[i];
+        }
+    }
+    free(old_table);
+    return true;
+}
+
+const char* string_arena_copy(StringArena* arena, const char* str) {
+    if (!arena || !str) return NULL;
+    return arena_copy(arena, str, strlen(str));
+}
+
+const char* string_arena_intern(StringArena* arena, const char* str) {
+    if (!arena || !str) return NULL;
+
+    uint32_t hash = hash_string(str);
+    uint32_t pos = table_probe(arena, str, hash);
+    if (arena->table[pos].str) return arena->table[pos].str;
+
+    // Keep the table at most half full
+    if ((arena->count + 1) * 2 > arena->table_capacity) {
+        if (!table_grow(arena)) return NULL;
+        pos = table_probe(arena, str, hash);
+    }
+
+    char* copy = arena_copy(arena, str, strlen(str));
+    if (!copy) return NULL;
+
+    arena->table[pos].str = copy;
+    arena->table[pos].hash = hash;
+    arena->count++;
+    return copy;
+}
+
+const char* string_arena_find(StringArena* arena, const char* str) {
+    if (!arena || !str) return NULL;
+    return arena->table[table_probe(arena, str, hash_string(str))].str;
+}
+
+StringArena* string_arena_fork(StringArena* arena) {
+    if (!arena || arena->blocks_forked) return NULL;
+
+    StringArena* fork = malloc(sizeof(StringArena));
+    if (!fork) return NULL;
+    *fork = *arena;
+    fork->table = malloc(arena->table_capacity * sizeof(StringArenaEntry));
+    if (!fork->table) {
+        free(fork);
+        return NULL;
+    }
+    memcpy(fork->table, arena->table, arena->table_capacity * sizeof(StringArenaEntry));
+    arena->blocks_forked = true;
+    return fork;
+}
+
+// Free the blocks in front of stop, newest first
+static void free_blocks(StringArenaBlock* block, StringArenaBlock* stop) {
+    while (block != stop) {
+        StringArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+}
+
+void string_arena_unfork(StringArena* fork, StringArena* arena) {
+    if (!fork || !arena) return;
+    free_blocks(fork->blocks, arena->blocks);
+    free(fork->table);
+    free(fork);
+    arena->blocks_forked = false;
+}
+
+void string_arena_destroy(StringArena* arena) {
+    if (!arena) return;
+
+    if (!arena->blocks_forked) free_blocks(arena->blocks, NULL);
+    free(arena->table);
+    free(arena);
+}
@@ -0,0 +1,55 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Append-only string storage with interning. Equal strings interned into the
+// same arena share one copy, so they can be compared by pointer. Everything is
+// released at once when the arena is destroyed.
+typedef struct StringArenaBlock StringArenaBlock;
+
+typedef struct {
+    const char* str;
+    uint32_t hash;
+} StringArenaEntry;
+
+typedef struct {
+    StringArenaBlock* blocks;     // Newest block first
+    char* cursor;                 // Next free byte in the newest block
+    size_t remaining;             // Free bytes left in the newest block
+    size_t next_block_size;
+    StringArenaEntry* table;      // Open-addressing intern table (str NULL = empty)
+    uint32_t table_capacity;      // Always a power of two
+    uint32_t count;               // Number of interned strings
+    size_t bytes_reserved;        // Total size of all blocks
+    bool blocks_forked;           // The blocks belong to a fork; destroy leaves them
+} StringArena;
+
+// FNV-1a hash used for interning and id lookups
+uint32_t hash_string(const char* str);
+
+StringArena* string_arena_create(void);
+
+// Copy str into the arena without interning it. NULL maps to NULL.
+const char* string_arena_copy(StringArena* arena, const char* str);
+
+// Return the arena's copy of str, adding it if needed. NULL maps to NULL.
+const char* string_arena_intern(StringArena* arena, const char* str);
+
+// Return the arena's copy of str if it has been interned, otherwise NULL
+const char* string_arena_find(StringArena* arena, const char* str);
+
+// Start a new arena that shares arena's strings and has its own copy of the
+// intern table. The blocks move to the fork: arena stays readable but must not
+// be added to again, and destroying it no longer frees them.
+StringArena* string_arena_fork(StringArena* arena);
+
+// Undo string_arena_fork: free the fork and the blocks it added, and give the
+// shared blocks back to arena
+void string_arena_unfork(StringArena* fork, StringArena* arena);
+
+void string_arena_destroy(StringArena* arena);
+
+#endif // STRING_ARENA_H
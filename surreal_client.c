@@ -1,5 +1,8 @@
 #include "surreal_client.h"
+#include "bead_catalog_file.h"
+#include "bead_snapshot.h"
 #include <curl/curl.h>
+#include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -11,7 +14,7 @@ static struct {
     char* username;
     char* password;
     CURL* curl;
-    BeadCollection* local_beads;  // Store beads locally for now
+    BeadCatalog* local_beads;     // Store beads locally for now
 } surreal_state = {0};
 
 // Helper struct for curl response
@@ -51,40 +54,26 @@ bool surreal_init(SurrealConfig config) {
 }
 
 bool surreal_save_bead(BeadDefinition* bead) {
-    // Initialize local collection if needed
-    if (!surreal_state.local_beads) {
-        printf("Creating new local bead collection\n");
-        surreal_state.local_beads = create_bead_collection();
-        if (!surreal_state.local_beads) {
-            printf("Error: Failed to create bead collection\n");
-            return false;
-        }
+    BeadCatalog* catalog = surreal_get_catalog();
+    BeadCollection* next = begin_bead_catalog_update(catalog);
+    if (!next) {
+        printf("Error: Failed to start bead collection update\n");
+        return false;
     }
     
-    // Generate ID if needed
-    if (!bead->id) {
+    // The collection interns its own copies of the text fields
+    BeadDefinition bead_copy = *bead;
+    // Generate ID if needed; it stays local until the bead is published
+    char id_buffer[32];
+    if (!bead_copy.id) {
         static int next_id = 1;
-        char id_buffer[32];
         snprintf(id_buffer, sizeof(id_buffer), "bead_%d", next_id++);
-        bead->id = strdup(id_buffer);
-        printf("Generated new bead ID: %s\n", bead->id);
+        bead_copy.id = id_buffer;
+        printf("Generated new bead ID: %s\n", bead_copy.id);
+    }
+    if (!bead_copy.category) {
+        bead_copy.category = "Default";
     }
-    
-    // Create deep copy of bead
-    BeadDefinition bead_copy;
-    memset(&bead_copy, 0, sizeof(BeadDefinition));  // Initialize to zero
-    
-    bead_copy.id = strdup(bead->id);
-    bead_copy.name = strdup(bead->name);
-    bead_copy.description = bead->description ? strdup(bead->description) : NULL;
-    bead_copy.category = bead->category ? strdup(bead->category) : strdup("Default");
-    bead_copy.material = bead->material;
-    bead_copy.shape = bead->shape;
-    bead_copy.finish = bead->finish;
-    bead_copy.color = bead->color;
-    bead_copy.image_id = bead->image_id;
-    bead_copy.size_mm = bead->size_mm;
-    bead_copy.is_premium = bead->is_premium;
     
     printf("Saving bead to local collection:\n");
     printf("  - ID: %s\n", bead_copy.id);
@@ -92,18 +81,19 @@ bool surreal_save_bead(BeadDefinition* bead) {
     printf("  - Image ID: %d\n", bead_copy.image_id);
     printf("  - Category: %s\n", bead_copy.category);
     
-    if (!add_bead_definition(surreal_state.local_beads, bead_copy)) {
-        // Clean up on failure
-        free((void*)bead_copy.id);
-        free((void*)bead_copy.name);
-        free((void*)bead_copy.description);
-        free((void*)bead_copy.category);
+    if (!add_bead_definition(next, bead_copy)) {
         printf("Error: Failed to add bead to collection!\n");
+        discard_bead_catalog_update(catalog, next);
         return false;
     }
     
-    printf("Successfully added bead to collection. Total beads: %d\n", 
-           surreal_state.local_beads->count);
+    printf("Successfully added bead to collection. Total beads: %d\n", next->count);
+    BeadDefinition* saved = find_bead_by_id(next, bead_copy.id);
+    publish_bead_catalog_update(catalog, next);
+    // Published strings live as long as the catalog (see bead_snapshot.h)
+    if (!bead->id && saved) {
+        bead->id = saved->id;
+    }
     return true;
 }
 
@@ -112,13 +102,41 @@ BeadDefinition* surreal_get_bead(const char* bead_id) {
     return NULL;  // Temporary mock implementation
 }
 
+BeadCatalog* surreal_get_catalog(void) {
+    if (!surreal_state.local_beads) {
+        printf("Creating new local bead collection\n");
+        BeadCollection* collection = create_bead_collection();
+        surreal_state.local_beads = create_bead_catalog(collection);
+        if (!surreal_state.local_beads) {
+            free_bead_collection(collection);
+        }
+    }
+    return surreal_state.local_beads;
+}
+
 BeadCollection* surreal_get_all_beads(void) {
     // Remove the curl check here too
     // if (!surreal_state.curl) return NULL;
-    if (!surreal_state.local_beads) {
-        surreal_state.local_beads = create_bead_collection();
+    BeadCatalog* catalog = surreal_get_catalog();
+    if (!catalog) return NULL;
+    BeadCollection* current = acquire_bead_snapshot(catalog);
+    release_bead_snapshot(catalog, current);
+    return current;
+}
+
+bool surreal_load_catalog(const char* path) {
+    BeadCollection* loaded = load_bead_catalog(path);
+    if (!loaded) return false;
+
+    BeadCatalog* catalog = create_bead_catalog(loaded);
+    if (!catalog) {
+        free_bead_collection(loaded);
+        return false;
     }
-    return surreal_state.local_beads;
+    free_bead_catalog(surreal_state.local_beads);
+    surreal_state.local_beads = catalog;
+    printf("Loaded %d beads from catalog %s\n", loaded->count, path);
+    return true;
 }
 
 bool surreal_delete_bead(const char* bead_id) {
@@ -138,6 +156,7 @@ void surreal_cleanup(void) {
     free(surreal_state.db);
     free(surreal_state.username);
     free(surreal_state.password);
+    free_bead_catalog(surreal_state.local_beads);
     
     memset(&surreal_state, 0, sizeof(surreal_state));
 } 
\ No newline at end of file
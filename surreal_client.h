@@ -2,6 +2,7 @@
 #define SURREAL_CLIENT_H
 
 #include "bead.h"
+#include "bead_snapshot.h"
 #include <stdbool.h>
 
 // Connection config
@@ -17,12 +18,23 @@ typedef struct {
 // Initialize connection
 bool surreal_init(SurrealConfig config);
 
-// Bead operations
+// Bead operations. Saving publishes a new version of the local store.
 bool surreal_save_bead(BeadDefinition* bead);
 bool surreal_delete_bead(const char* bead_id);
 BeadDefinition* surreal_get_bead(const char* bead_id);
+
+// The local bead store. Readers pin a version with acquire_bead_snapshot;
+// writers go through begin_bead_catalog_update.
+BeadCatalog* surreal_get_catalog(void);
+
+// Current version of the local store, unpinned: a later save may free it.
+// Prefer acquire_bead_snapshot(surreal_get_catalog()).
 BeadCollection* surreal_get_all_beads(void);
 
+// Replace the local bead store with a binary catalog file (see bead_catalog_file.h).
+// Call before handing out the store; on failure the store is left unchanged.
+bool surreal_load_catalog(const char* path);
+
 // Cleanup
 void surreal_cleanup(void);
 